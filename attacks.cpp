@@ -0,0 +1,179 @@
+#include "attacks.h"
+
+magic_t rook_magics[64];
+magic_t bishop_magics[64];
+
+board_t between_masks[64][64];
+board_t line_masks[64][64];
+board_t pawn_attack_masks[2][64];
+
+// every square has a table of 2^(number of relevant blockers) entries
+// the tables of all squares are stored one after another
+static board_t rook_table[0x19000];
+static board_t bishop_table[0x1480];
+
+static const int rook_directions[4][2] = { { 1, 0 }, { -1, 0 }, { 0, 1 }, { 0, -1 } };
+static const int bishop_directions[4][2] = { { 1, 1 }, { 1, -1 }, { -1, 1 }, { -1, -1 } };
+
+// slow attack generation, only used to fill the tables
+static board_t sliding_attacks(square_t square, board_t occupied, const int directions[4][2])
+{
+    board_t attacks = 0;
+
+    for (int i = 0; i < 4; i++)
+    {
+        int row = square / 8 + directions[i][0];
+        int col = square % 8 + directions[i][1];
+
+        while (row >= 0 && row < 8 && col >= 0 && col < 8)
+        {
+            board_t square_mask = 1ull << (8 * row + col);
+            attacks |= square_mask;
+
+            if (occupied & square_mask)
+                break;
+
+            row += directions[i][0];
+            col += directions[i][1];
+        }
+    }
+
+    return attacks;
+}
+
+// https://www.chessprogramming.org/Xorshift
+// magic candidates should have few bits set so three random numbers are and-ed together
+struct magic_rng_t
+{
+    uint64_t state;
+
+    uint64_t next()
+    {
+        state ^= state >> 12;
+        state ^= state << 25;
+        state ^= state >> 27;
+        return state * 2685821657736338717ull;
+    }
+
+    uint64_t sparse()
+    {
+        return next() & next() & next();
+    }
+};
+
+static void init_magics(magic_t magics[64], board_t* table, const int directions[4][2])
+{
+    const board_t rank_1 = 0xffull;
+    const board_t rank_8 = 0xffull << 56;
+    const board_t file_a = 0x0101010101010101ull;
+    const board_t file_h = file_a << 7;
+
+    static board_t occupancy[4096];
+    static board_t reference[4096];
+    static int attempt[4096];
+
+    // seeds (one per rank) that are known to find all the magics quickly, taken from stockfish
+    const uint64_t seeds[8] = { 728, 10316, 55013, 32803, 12281, 15100, 16645, 255 };
+
+    int attempt_count = 0;
+    board_t* attacks = table;
+
+    for (square_t square = 0; square < 64; square++)
+    {
+        // pieces on the edge of the board never block anything
+        board_t rank_mask = rank_1 << (8 * (square / 8));
+        board_t file_mask = file_a << (square % 8);
+        board_t edges = ((rank_1 | rank_8) & ~rank_mask) | ((file_a | file_h) & ~file_mask);
+
+        magic_t& m = magics[square];
+        m.mask = sliding_attacks(square, 0, directions) & ~edges;
+        m.shift = 64 - (uint32_t)__popcnt64(m.mask);
+        m.attacks = attacks;
+
+        // https://www.chessprogramming.org/Traversing_Subsets_of_a_Set
+        int size = 0;
+        board_t b = 0;
+        do
+        {
+            occupancy[size] = b;
+            reference[size] = sliding_attacks(square, b, directions);
+            size++;
+            b = (b - m.mask) & m.mask;
+        } while (b);
+
+        attacks += size;
+
+#ifdef USE_PEXT
+        for (int i = 0; i < size; i++)
+            m.attacks[m.index(occupancy[i])] = reference[i];
+#else
+        magic_rng_t rng = { seeds[square / 8] };
+
+        // tries random numbers until one maps every blocker combination without a destructive collision
+        // attempt[] remembers which try wrote an entry so the table doesn't have to be cleared between tries
+        for (int i = 0; i < size; )
+        {
+            do
+                m.magic = rng.sparse();
+            while (__popcnt64((m.magic * m.mask) >> 56) < 6);
+
+            attempt_count++;
+
+            for (i = 0; i < size; i++)
+            {
+                uint32_t index = m.index(occupancy[i]);
+
+                if (attempt[index] < attempt_count)
+                {
+                    attempt[index] = attempt_count;
+                    m.attacks[index] = reference[i];
+                }
+                else if (m.attacks[index] != reference[i])
+                    break;
+            }
+        }
+#endif
+    }
+}
+
+// needs the magic tables so it has to run after init_magics
+static void init_lines()
+{
+    const board_t file_a = 0x0101010101010101ull;
+    const board_t file_h = file_a << 7;
+
+    for (square_t s1 = 0; s1 < 64; s1++)
+    {
+        board_t b1 = 1ull << s1;
+
+        pawn_attack_masks[0][s1] = ((b1 << 7) & ~file_h) | ((b1 << 9) & ~file_a);
+        pawn_attack_masks[1][s1] = ((b1 >> 9) & ~file_h) | ((b1 >> 7) & ~file_a);
+
+        for (square_t s2 = 0; s2 < 64; s2++)
+        {
+            board_t b2 = 1ull << s2;
+
+            if (rook_attacks(s1, 0) & b2)
+            {
+                line_masks[s1][s2] = (rook_attacks(s1, 0) & rook_attacks(s2, 0)) | b1 | b2;
+                between_masks[s1][s2] = rook_attacks(s1, b2) & rook_attacks(s2, b1);
+            }
+            else if (bishop_attacks(s1, 0) & b2)
+            {
+                line_masks[s1][s2] = (bishop_attacks(s1, 0) & bishop_attacks(s2, 0)) | b1 | b2;
+                between_masks[s1][s2] = bishop_attacks(s1, b2) & bishop_attacks(s2, b1);
+            }
+        }
+    }
+}
+
+// the tables are filled before main is called
+static struct magic_initializer_t
+{
+    magic_initializer_t()
+    {
+        init_magics(rook_magics, rook_table, rook_directions);
+        init_magics(bishop_magics, bishop_table, bishop_directions);
+        init_lines();
+    }
+} magic_initializer;
@@ -0,0 +1,184 @@
+#pragma once
+
+#include <cstdint>
+#include <array>
+
+#include <intrin.h>
+
+// board_t and square_t are the same types as in board.h
+using board_t = uint64_t;
+using square_t = uint32_t;
+
+constexpr board_t square_mask(int row, int col)
+{
+    return 1ull << (8 * row + col);
+}
+
+constexpr board_t king_am(int row, int col)
+{
+    board_t mask = 0;
+    if (row > 0)
+        mask |= square_mask(row - 1, col);
+    if (row < 7)
+        mask |= square_mask(row + 1, col);
+    if (col > 0)
+        mask |= square_mask(row, col - 1);
+    if (col < 7)
+        mask |= square_mask(row, col + 1);
+    if (row > 0 && col > 0)
+        mask |= square_mask(row - 1, col - 1);
+    if (row > 0 && col < 7)
+        mask |= square_mask(row - 1, col + 1);
+    if (row < 7 && col > 0)
+        mask |= square_mask(row + 1, col - 1);
+    if (row < 7 && col < 7)
+        mask |= square_mask(row + 1, col + 1);
+
+    return mask;
+}
+
+constexpr board_t knight_am(int row, int col)
+{
+    board_t mask = 0;
+    if (row - 2 >= 0 && col - 1 >= 0)
+        mask |= square_mask(row - 2, col - 1);
+    if (row - 2 >= 0 && col + 1 <= 7)
+        mask |= square_mask(row - 2, col + 1);
+    if (row - 1 >= 0 && col - 2 >= 0)
+        mask |= square_mask(row - 1, col - 2);
+    if (row - 1 >= 0 && col + 2 <= 7)
+        mask |= square_mask(row - 1, col + 2);
+    if (row + 1 <= 7 && col - 2 >= 0)
+        mask |= square_mask(row + 1, col - 2);
+    if (row + 1 <= 7 && col + 2 <= 7)
+        mask |= square_mask(row + 1, col + 2);
+    if (row + 2 <= 7 && col - 1 >= 0)
+        mask |= square_mask(row + 2, col - 1);
+    if (row + 2 <= 7 && col + 1 <= 7)
+        mask |= square_mask(row + 2, col + 1);
+
+    return mask;
+}
+
+// rook and bishop masks ignore blockers, they are used to find pieces that could attack a square
+constexpr board_t rook_am(int row, int col)
+{
+    board_t mask = 0;
+
+    for (int i = 0; i < 8; ++i)
+    {
+        if (i != col)
+            mask |= square_mask(row, i);
+        if (i != row)
+            mask |= square_mask(i, col);
+    }
+
+    return mask;
+}
+
+constexpr board_t bishop_am(int row, int col)
+{
+    board_t mask = 0;
+
+    for (int i = 1; i < 8; ++i)
+    {
+        if (row + i < 8 && col + i < 8)
+            mask |= square_mask(row + i, col + i);
+        if (row + i < 8 && col - i >= 0)
+            mask |= square_mask(row + i, col - i);
+        if (row - i >= 0 && col + i < 8)
+            mask |= square_mask(row - i, col + i);
+        if (row - i >= 0 && col - i >= 0)
+            mask |= square_mask(row - i, col - i);
+    }
+
+    return mask;
+}
+
+constexpr board_t queen_am(int row, int col)
+{
+    return rook_am(row, col) | bishop_am(row, col);
+}
+
+// fills a table with one mask per square, when used to initialise a constexpr table it runs at compile time
+template <typename F>
+constexpr std::array<board_t, 64> square_table(F mask_function)
+{
+    std::array<board_t, 64> table = {};
+
+    for (int square = 0; square < 64; ++square)
+        table[square] = mask_function(square / 8, square % 8);
+
+    return table;
+}
+
+/*
+precomputed moves for each piece exept pawns, shared by every board.
+sience every function used is constexpr the tables are computed at compile time
+*/
+inline constexpr std::array<board_t, 64> attacking_mask_king = square_table(king_am);
+inline constexpr std::array<board_t, 64> attacking_mask_knight = square_table(knight_am);
+inline constexpr std::array<board_t, 64> attacking_mask_rook = square_table(rook_am);
+inline constexpr std::array<board_t, 64> attacking_mask_bishop = square_table(bishop_am);
+inline constexpr std::array<board_t, 64> attacking_mask_queen = square_table(queen_am);
+
+// https://www.chessprogramming.org/BMI2#PEXT_Bitboards
+// on cpus with BMI2 the magic multiplication can be replaced with a single pext instruction
+// msvc doesn't define __BMI2__ but every cpu with AVX2 (/arch:AVX2) also supports BMI2
+#if defined(__BMI2__) || defined(__AVX2__)
+#define USE_PEXT
+#endif
+
+/*
+https://www.chessprogramming.org/Magic_Bitboards
+sliding pieces attacks are looked up in a precomputed table.
+the blockers that matter (mask) are hashed in to an index with a multiplication by a magic number
+so all four directions of a rook or a bishop are returned by a single table lookup
+*/
+struct magic_t
+{
+    board_t mask;
+    board_t magic;
+    board_t* attacks;
+    uint32_t shift;
+
+    uint32_t index(board_t occupied) const
+    {
+#ifdef USE_PEXT
+        return (uint32_t)_pext_u64(occupied, mask);
+#else
+        return (uint32_t)(((occupied & mask) * magic) >> shift);
+#endif
+    }
+};
+
+extern magic_t rook_magics[64];
+extern magic_t bishop_magics[64];
+
+inline board_t rook_attacks(square_t square, board_t occupied)
+{
+    const magic_t& m = rook_magics[square];
+    return m.attacks[m.index(occupied)];
+}
+
+inline board_t bishop_attacks(square_t square, board_t occupied)
+{
+    const magic_t& m = bishop_magics[square];
+    return m.attacks[m.index(occupied)];
+}
+
+inline board_t queen_attacks(square_t square, board_t occupied)
+{
+    return rook_attacks(square, occupied) | bishop_attacks(square, occupied);
+}
+
+// squares strictly between two squares on the same rank, file or diagonal (0 if they are not aligned)
+// used for check blocking and pins
+extern board_t between_masks[64][64];
+
+// the whole rank, file or diagonal going through both squares (0 if they are not aligned)
+// a pinned piece can only move along the line through its king
+extern board_t line_masks[64][64];
+
+// squares attacked by a pawn standing on a square, [0] - white pawns, [1] - black pawns
+extern board_t pawn_attack_masks[2][64];
@@ -15,394 +15,132 @@ vector<string> ChessBoard::split(string s) {
     return components;
 }
 
-void ChessBoard::generate_pawn_white_moves(vector<move_t>& valid_moves, vector<move_t>& candidate_moves, uint32_t pos, bool only_captures)
+void ChessBoard::init_legality_masks()
 {
-    int row = get_row(pos);
-    int col = get_col(pos);
-
-    // If in check, the moves must be examined later
-    // If not in check, some moves are validated in this function
-    vector<move_t>& proposed_moves = (!white_in_check) ? valid_moves : candidate_moves;
-
-    if (!only_captures && !is_square_occupied(pos + 8)) {
-        if (row == 1 && !is_square_occupied(pos + 16)) {
-            add_move_with_control(proposed_moves, piece_no_color_t::pawn, pos, pos + 8);
-            add_move_with_control(proposed_moves, piece_no_color_t::pawn, pos, pos + 16);
-        }
-        else if (row == 6) {
-            add_move_pr_with_control(proposed_moves, candidate_moves, piece_no_color_t::pawn, pos, pos + 8, color_t::white);
-        }
-        else
-            add_move_with_control(proposed_moves, piece_no_color_t::pawn, pos, pos + 8);
-    }
-
-    if (col > 0 && is_square_black(pos + 7)) {
-        if (row == 6) {
-            add_move_pr_with_control(proposed_moves, candidate_moves, piece_no_color_t::pawn, pos, pos + 7, color_t::white);
-        }
-        else
-            add_move_with_control(proposed_moves, piece_no_color_t::pawn, pos, pos + 7);
-    }
-    if (col < 7 && is_square_black(pos + 9)) {
-        if (row == 6) {
-            add_move_pr_with_control(proposed_moves, candidate_moves, piece_no_color_t::pawn, pos, pos + 9, color_t::white);
-        }
-        else
-            add_move_with_control(proposed_moves, piece_no_color_t::pawn, pos, pos + 9);
-    }
-}
-
-void ChessBoard::generate_pawn_black_moves(vector<move_t>& valid_moves, vector<move_t>& candidate_moves, uint32_t pos, bool only_captures)
-{
-    int row = get_row(pos);
-    int col = get_col(pos);
-
-    // If in check, the moves must be examined later
-    // If not in check, some moves are validated in this function
-    vector<move_t>& proposed_moves = (!black_in_check) ? valid_moves : candidate_moves;
-
-    if (!only_captures && !is_square_occupied(pos - 8)) {
-        if (row == 6 && !is_square_occupied(pos - 16)) {
-            add_move_with_control(proposed_moves, piece_no_color_t::pawn, pos, pos - 8);
-            add_move_with_control(proposed_moves, piece_no_color_t::pawn, pos, pos - 16);
-        }
-        else if (row == 1) {
-            add_move_pr_with_control(proposed_moves, candidate_moves, piece_no_color_t::pawn, pos, pos - 8, color_t::black);
-        }
-        else {
-            add_move_with_control(proposed_moves, piece_no_color_t::pawn, pos, pos - 8);
-        }
-    }
-
-    if (col > 0 && is_square_white(pos - 9)) {
-        if (row == 1) {
-            add_move_pr_with_control(proposed_moves, candidate_moves, piece_no_color_t::pawn, pos, pos - 9, color_t::black);
-        }
-        else {
-            add_move_with_control(proposed_moves, piece_no_color_t::pawn, pos, pos - 9);
-        }
-    }
-
-    if (col < 7 && is_square_white(pos - 7)) {
-        if (row == 1) {
-            add_move_pr_with_control(proposed_moves, candidate_moves, piece_no_color_t::pawn, pos, pos - 7, color_t::black);
-        }
-        else {
-            add_move_with_control(proposed_moves, piece_no_color_t::pawn, pos, pos - 7);
-        }
-    }
-}
-
-void ChessBoard::generate_rook_all_moves(piece_no_color_t moving_piece, vector<move_t>& valid_moves, vector<move_t>& candidate_moves, uint32_t pos)
-{
-    vector<move_t>& proposed_moves = king_in_check ? candidate_moves : valid_moves;
-
-    board_t pieces = white | black;
-    board_t opp = white_to_move ? black : white;
-    int m, k;
-
-    board_t mask = attacking_mask_rook_up[pos] & pieces;
-    m = bit_pos_lsb(mask);
-
-    if (mask && is_bit_set(opp, m))
-        m += 8;
-
-    for (k = pos + 8; k < m; k += 8)
-        add_move_with_control(proposed_moves, moving_piece, pos, k);
-
-    mask = attacking_mask_rook_down[pos] & pieces;
-    m = bit_pos_msb(mask);
-
-    if (mask && is_bit_set(opp, m))
-        m -= 8;
-
-    for (k = pos - 8; k > m; k -= 8)
-        add_move_with_control(proposed_moves, moving_piece, pos, k);
-
-    mask = attacking_mask_rook_right[pos] & pieces;
-    m = bit_pos_lsb(mask);
-
-    if (mask)
-    {
-        if (is_bit_set(opp, m))
-            m += 1;
-    }
-    else
-        m = (pos & ~0x7u) + 8;
+    color_mask = white_to_move ? white : black;
+    opp_color_mask = white_to_move ? black : white;
 
-    for (k = pos + 1; k < m; ++k)
-        add_move_with_control(proposed_moves, moving_piece, pos, k);
+    board_t occupied = white | black;
 
-    mask = attacking_mask_rook_left[pos] & pieces;
-    m = bit_pos_msb(mask);
+    king_pos = bit_pos(color_mask & kings);
+    checkers = attackers_to(king_pos, occupied) & opp_color_mask;
+    king_in_check = checkers != 0;
 
-    if (mask)
-    {
-        if (is_bit_set(opp, m))
-            --m;
-    }
+    if (!checkers)
+        check_mask = ~0ull;
+    else if (!(checkers & (checkers - 1)))
+        check_mask = checkers | between_masks[king_pos][bit_pos(checkers)];
     else
-        m = (int)(pos & ~7u) - (int)1;
-
-    for (k = pos - 1; k > m; --k)
-        add_move_with_control(proposed_moves, moving_piece, pos, k);
-}
+        check_mask = 0;
 
-void ChessBoard::generate_rook_capture_moves(piece_no_color_t moving_piece, vector<move_t>& valid_moves, vector<move_t>& candidate_moves, uint32_t pos)
-{
-    vector<move_t>& proposed_moves = king_in_check ? candidate_moves : valid_moves;
-
-    board_t pieces = white | black;
-    board_t opp = white_to_move ? black : white;
-    int m, k;
-
-    board_t mask = attacking_mask_rook_up[pos] & pieces;
-    m = bit_pos_lsb(mask);
-
-    if (mask && is_bit_set(opp, m))
-        add_move_with_control(proposed_moves, moving_piece, pos, m);
-
-    mask = attacking_mask_rook_down[pos] & pieces;
-    m = bit_pos_msb(mask);
+    // an enemy slider that would attack the king on an empty board pins an own piece
+    // if that piece is the only one standing between them
+    pinned = 0;
 
-    if (mask && is_bit_set(opp, m))
-        add_move_with_control(proposed_moves, moving_piece, pos, m);
-
-    mask = attacking_mask_rook_right[pos] & pieces;
-    m = bit_pos_lsb(mask);
-
-    if (mask)
+    board_t snipers = opp_color_mask & ((attacking_mask_rook[king_pos] & (rooks | queens)) | (attacking_mask_bishop[king_pos] & (bishops | queens)));
+    for (; snipers; snipers &= snipers - 1)
     {
-        if (is_bit_set(opp, m))
-            add_move_with_control(proposed_moves, moving_piece, pos, m);
-    }
-
-    mask = attacking_mask_rook_left[pos] & pieces;
-    m = bit_pos_msb(mask);
+        board_t blockers = between_masks[king_pos][bit_pos(snipers)] & occupied;
 
-    if (mask)
-    {
-        if (is_bit_set(opp, m))
-            add_move_with_control(proposed_moves, moving_piece, pos, m);
+        if (blockers && !(blockers & (blockers - 1)))
+            pinned |= blockers & color_mask;
     }
 }
 
-void ChessBoard::generate_bishop_all_moves(piece_no_color_t moving_piece, vector<move_t>& valid_moves, vector<move_t>& candidate_moves, uint32_t pos)
+void ChessBoard::generate_pawn_white_moves(MoveList& valid_moves, uint32_t pos, move_gen_t gen)
 {
-    // If in check, the moves must be examined later
-    // If not in check, some moves are validated in this function
-    vector<move_t>& proposed_moves = king_in_check ? candidate_moves : valid_moves;
-
-    board_t pieces = white | black;
-    board_t opp = white_to_move ? black : white;
-    int m, k;
-
-    board_t mask;
-
-    int row = get_row(pos);
-    int col = get_col(pos);
-
-    mask = attacking_mask_bishop_right_up[pos] & pieces;
-    m = bit_pos_lsb(mask);
+    board_t allowed = legal_mask(pos);
+    board_t pushes = 0;
+    board_t captures = 0;
 
-    if (mask)
-    {
-        if (is_bit_set(opp, m))
-            m += 9;
-    }
-    else
-    {
-        m = (8 - (pos & 7u)) * 9 + pos;
+    if (gen != move_gen_t::captures && !is_square_occupied(pos + 8)) {
+        pushes = (1ull << (pos + 8)) & allowed;
 
-        if (m > 63)
-            m = 64;
+        // the double push can block a check even if the single push doesn't
+        if (get_row(pos) == 1 && !is_square_occupied(pos + 16))
+            pushes |= (1ull << (pos + 16)) & allowed;
     }
 
-    for (k = pos + 9; k < m; k += 9)
-        add_move_with_control(proposed_moves, moving_piece, pos, k);
+    if (gen != move_gen_t::quiets)
+        captures = pawn_attack_masks[0][pos] & opp_color_mask & allowed;
 
-    mask = attacking_mask_bishop_left_down[pos] & pieces;
-    m = bit_pos_msb(mask);
+    if (get_row(pos) == 6) {
+        if (pushes)
+            add_promotions(valid_moves, pos, pos + 8);
 
-    if (mask)
-    {
-        if (is_bit_set(opp, m))
-            m -= 9;
-    }
-    else
-    {
-        m = (int)pos - (int)(pos & 7u) * 9 - 9;
-
-        if (m < 0)
-            m = -1;
-    }
-
-    for (k = pos - 9; k > m; k -= 9)
-        add_move_with_control(proposed_moves, moving_piece, pos, k);
-
-    mask = attacking_mask_bishop_left_up[pos] & pieces;
-    m = bit_pos_lsb(mask);
-
-    if (mask)
-    {
-        if (is_bit_set(opp, m))
-            m += 7;
-    }
-    else
-    {
-        m = (int)pos + (int)(pos & 7u) * 7 + 7;
-
-        if (m > 63)
-            m = 64;
-    }
-
-    for (k = pos + 7; k < m; k += 7)
-        add_move_with_control(proposed_moves, moving_piece, pos, k);
-
-    mask = attacking_mask_bishop_right_down[pos] & pieces;
-    m = bit_pos_msb(mask);
-
-    if (mask)
-    {
-        if (is_bit_set(opp, m))
-            m -= 7;
+        for (; captures; captures &= captures - 1)
+            add_promotions(valid_moves, pos, bit_pos(captures));
     }
-    else
-    {
-        m = (int)pos - (int)(8 - (pos & 7u)) * 7;
-
-        if (m < 0)
-            m = -1;
+    else {
+        add_moves(valid_moves, piece_no_color_t::pawn, pos, pushes);
+        add_moves(valid_moves, piece_no_color_t::pawn, pos, captures);
     }
-
-    for (k = pos - 7; k > m; k -= 7)
-        add_move_with_control(proposed_moves, moving_piece, pos, k);
 }
 
-void ChessBoard::generate_bishop_capture_moves(piece_no_color_t moving_piece, vector<move_t>& valid_moves, vector<move_t>& candidate_moves, uint32_t pos)
+void ChessBoard::generate_pawn_black_moves(MoveList& valid_moves, uint32_t pos, move_gen_t gen)
 {
-    // If in check, the moves must be examined later
-    // If not in check, some moves are validated in this function
-    vector<move_t>& proposed_moves = king_in_check ? candidate_moves : valid_moves;
-
-    board_t pieces = white | black;
-    board_t opp = white_to_move ? black : white;
-    int m, k;
-
-    board_t mask;
-
-    int row = get_row(pos);
-    int col = get_col(pos);
+    board_t allowed = legal_mask(pos);
+    board_t captures = 0;
 
-    mask = attacking_mask_bishop_right_up[pos] & pieces;
-    m = bit_pos_lsb(mask);
-
-    if (mask)
-    {
-        if (is_bit_set(opp, m))
-            add_move_with_control(proposed_moves, moving_piece, pos, m);
-    }
-
-    mask = attacking_mask_bishop_left_down[pos] & pieces;
-    m = bit_pos_msb(mask);
-
-    if (mask)
-    {
-        if (is_bit_set(opp, m))
-            add_move_with_control(proposed_moves, moving_piece, pos, m);
-    }
-
-    mask = attacking_mask_bishop_left_up[pos] & pieces;
-    m = bit_pos_lsb(mask);
+    if (gen != move_gen_t::captures && !is_square_occupied(pos - 8)) {
+        if (get_row(pos) == 1) {
+            if (allowed & (1ull << (pos - 8)))
+                add_promotions(valid_moves, pos, pos - 8);
+        }
+        else {
+            add_moves(valid_moves, piece_no_color_t::pawn, pos, (1ull << (pos - 8)) & allowed);
 
-    if (mask)
-    {
-        if (is_bit_set(opp, m))
-            add_move_with_control(proposed_moves, moving_piece, pos, m);
+            if (get_row(pos) == 6 && !is_square_occupied(pos - 16))
+                add_moves(valid_moves, piece_no_color_t::pawn, pos, (1ull << (pos - 16)) & allowed);
+        }
     }
 
-    mask = attacking_mask_bishop_right_down[pos] & pieces;
-    m = bit_pos_msb(mask);
+    if (gen != move_gen_t::quiets)
+        captures = pawn_attack_masks[1][pos] & opp_color_mask & allowed;
 
-    if (mask)
-    {
-        if (is_bit_set(opp, m))
-            add_move_with_control(proposed_moves, moving_piece, pos, m);
+    if (get_row(pos) == 1) {
+        for (; captures; captures &= captures - 1)
+            add_promotions(valid_moves, pos, bit_pos(captures));
     }
+    else
+        add_moves(valid_moves, piece_no_color_t::pawn, pos, captures);
 }
 
-void ChessBoard::generate_queen_all_moves(vector<move_t>& valid_moves, vector<move_t>& candidate_moves, uint32_t pos)
-{
-    generate_rook_all_moves(piece_no_color_t::queen, valid_moves, candidate_moves, pos);
-    generate_bishop_all_moves(piece_no_color_t::queen, valid_moves, candidate_moves, pos);
-}
-
-void ChessBoard::generate_queen_capture_moves(vector<move_t>& valid_moves, vector<move_t>& candidate_moves, uint32_t pos)
+void ChessBoard::generate_rook_moves(piece_no_color_t moving_piece, MoveList& valid_moves, uint32_t pos, board_t targets)
 {
-    generate_rook_capture_moves(piece_no_color_t::queen, valid_moves, candidate_moves, pos);
-    generate_bishop_capture_moves(piece_no_color_t::queen, valid_moves, candidate_moves, pos);
+    add_moves(valid_moves, moving_piece, pos, rook_attacks(pos, white | black) & targets & legal_mask(pos));
 }
 
-void ChessBoard::generate_knight_all_moves(vector<move_t>& valid_moves, vector<move_t>& candidate_moves, uint32_t pos)
+void ChessBoard::generate_bishop_moves(piece_no_color_t moving_piece, MoveList& valid_moves, uint32_t pos, board_t targets)
 {
-    vector<move_t>& proposed_moves = king_in_check ? candidate_moves : valid_moves;
-
-    for (board_t b = ~color_mask & attacking_mask_knight[pos]; b; b &= b - 1)
-        add_move_with_control(proposed_moves, piece_no_color_t::knight, pos, bit_pos(b));
+    add_moves(valid_moves, moving_piece, pos, bishop_attacks(pos, white | black) & targets & legal_mask(pos));
 }
 
-void ChessBoard::generate_knight_capture_moves(vector<move_t>& valid_moves, vector<move_t>& candidate_moves, uint32_t pos)
+void ChessBoard::generate_queen_moves(MoveList& valid_moves, uint32_t pos, board_t targets)
 {
-    board_t opp = white_to_move ? black : white;
-
-    vector<move_t>& proposed_moves = king_in_check ? candidate_moves : valid_moves;
-
-    for (board_t b = ~color_mask & attacking_mask_knight[pos]; b; b &= b - 1)
-        if (is_bit_set(opp, bit_pos(b)))
-            add_move_with_control(proposed_moves, piece_no_color_t::knight, pos, bit_pos(b));
+    add_moves(valid_moves, piece_no_color_t::queen, pos, queen_attacks(pos, white | black) & targets & legal_mask(pos));
 }
 
-void ChessBoard::generate_king_all_moves(vector<move_t>& valid_moves, vector<move_t>& candidate_moves, uint32_t pos)
+void ChessBoard::generate_knight_moves(MoveList& valid_moves, uint32_t pos, board_t targets)
 {
-    board_t& pieces = (white_to_move ? white : black);
-    board_t old_kings = kings;
-    board_t old_pieces = pieces;
-
-    for (board_t b = ~color_mask & attacking_mask_king[pos]; b; b &= b - 1)
-    {
-        int new_pos = bit_pos(b);
-
-        kings = move_piece_in_bit_mask(kings, pos, new_pos);
-        pieces = move_piece_in_bit_mask(pieces, pos, new_pos);
-        if (!is_attacked(new_pos, white_to_move))
-            valid_moves.push_back(encode_move(piece_no_color_t::king, pos, bit_pos(b)));
+    // a pinned knight can never move
+    if (pinned & (1ull << pos))
+        return;
 
-        kings = old_kings;
-        pieces = old_pieces;
-    }
+    add_moves(valid_moves, piece_no_color_t::knight, pos, attacking_mask_knight[pos] & targets & check_mask);
 }
 
-void ChessBoard::generate_king_capture_moves(vector<move_t>& valid_moves, vector<move_t>& candidate_moves, uint32_t pos)
+void ChessBoard::generate_king_moves(MoveList& valid_moves, uint32_t pos, board_t targets)
 {
-    board_t& pieces = (white_to_move ? white : black);
-    board_t old_kings = kings;
-    board_t old_pieces = pieces;
-    board_t opp = white_to_move ? black : white;
+    // the king is lifted off the board so it doesn't hide the squares behind it from a checking slider
+    board_t occupied = (white | black) & ~(1ull << pos);
 
-    for (board_t b = ~color_mask & attacking_mask_king[pos]; b; b &= b - 1)
+    for (board_t b = attacking_mask_king[pos] & targets; b; b &= b - 1)
     {
         int new_pos = bit_pos(b);
 
-        if (!is_bit_set(opp, new_pos))
-            continue;
-
-        kings = move_piece_in_bit_mask(kings, pos, new_pos);
-        pieces = move_piece_in_bit_mask(pieces, pos, new_pos);
-        if (!is_attacked(new_pos, white_to_move))
-            valid_moves.push_back(encode_move(piece_no_color_t::king, pos, bit_pos(b)));
-
-        kings = old_kings;
-        pieces = old_pieces;
+        if (!(attackers_to(new_pos, occupied) & opp_color_mask))
+            valid_moves.push_back(encode_move(piece_no_color_t::king, pos, new_pos));
     }
 }
 
@@ -522,6 +260,13 @@ void ChessBoard::from_fen(string fen) {
     else {
         en_passant = encode_ep(components[3][1] - '1', components[3][0] - 'a');
     }
+
+    // the halfmove clock is optional in some fens
+    if (components.size() > 4)
+        last_pawn_move = stoi(components[4]);
+
+    update_mailbox(~0ull);
+    init_keys();
 }
 
 string ChessBoard::get_fen()
@@ -545,7 +290,7 @@ string ChessBoard::get_fen()
             fen.push_back('/');
         }
 
-        switch (get_piece_type(square))
+        switch (mailbox[square])
         {
         case piece_t::empty:
             dif++;
@@ -705,32 +450,38 @@ string ChessBoard::get_fen()
     return fen;
 }
 
-void ChessBoard::add_en_passant(vector<move_t>& valid_moves, vector<move_t>& candidate_moves)
+void ChessBoard::add_en_passant(MoveList& valid_moves)
 {
     if (en_passant == ep_empty)
         return;
 
-    vector<move_t>& proposed_moves = ((white_to_move && !white_in_check) || (!white_to_move && !black_in_check)) ? valid_moves : candidate_moves;
-
-    uint32_t ep_row = get_ep_row(en_passant);
-    uint32_t ep_col = get_ep_col(en_passant);
     uint32_t pos = en_passant;
+    uint32_t takeover_pos = white_to_move ? pos - 8 : pos + 8;
 
-    if (ep_row == 5) {
-        if (ep_col < 7 && is_white_pawn(pos - 7))
-            add_move_ep_with_control(proposed_moves, piece_no_color_t::pawn, pos - 7, pos);
-        if (ep_col > 0 && is_white_pawn(pos - 9))
-            add_move_ep_with_control(proposed_moves, piece_no_color_t::pawn, pos - 9, pos);
-    }
-    if (ep_row == 2) {
-        if (ep_col < 7 && is_black_pawn(pos + 9))
-            add_move_ep_with_control(proposed_moves, piece_no_color_t::pawn, pos + 9, pos);
-        if (ep_col > 0 && is_black_pawn(pos + 7))
-            add_move_ep_with_control(proposed_moves, piece_no_color_t::pawn, pos + 7, pos);
+    // the capture has to either take the checking pawn or block the check
+    if (!(check_mask & ((1ull << pos) | (1ull << takeover_pos))))
+        return;
+
+    // our pawns that attack the en-passant square stand where an enemy pawn on it would attack
+    for (board_t b = pawn_attack_masks[white_to_move ? 1 : 0][pos] & pawns & color_mask; b; )
+    {
+        uint32_t pos_from = bit_pos_msb(b);
+        bit_reset(b, pos_from);
+
+        // both pawns leave their rank at once so pins are tested on the position after the capture
+        board_t occupied = ((white | black) & ~(1ull << pos_from) & ~(1ull << takeover_pos)) | (1ull << pos);
+        board_t attackers = opp_color_mask & ~(1ull << takeover_pos);
+
+        if (rook_attacks(king_pos, occupied) & attackers & (rooks | queens))
+            continue;
+        if (bishop_attacks(king_pos, occupied) & attackers & (bishops | queens))
+            continue;
+
+        valid_moves.push_back(encode_move(piece_no_color_t::pawn, pos_from, pos));
     }
 }
 
-void ChessBoard::add_castleing(vector<move_t>& valid_moves, vector<move_t>& candidate_moves)
+void ChessBoard::add_castleing(MoveList& valid_moves)
 {
     if (white_to_move && get_castle_white_short(castlings) && !is_square_occupied(5) && !is_square_occupied(6) && !is_attacked(5, true) && !is_attacked(6, true))
         valid_moves.push_back(encode_move(piece_no_color_t::king, 4, 6));
@@ -765,350 +516,262 @@ void ChessBoard::visualise() {
 
 bool ChessBoard::is_attacked(uint32_t pos, bool white_move)
 {
-    board_t opp = white_move ? black : white;
+    return attackers_to(pos, white | black) & (white_move ? black : white);
+}
 
-    // Queen's and rook's attacks
-    board_t opp_rook_mask = opp & (queens | rooks);
-    board_t mask_blockers = (black | white) & ~opp_rook_mask;
+bool ChessBoard::in_check()
+{
+    return is_attacked(get_king_pos(white_to_move), white_to_move);
+}
 
-    if (opp_rook_mask & attacking_mask_rook[pos])
+bool ChessBoard::is_legal_position()
+{
+    if (__popcnt64(kings & white) != 1 || __popcnt64(kings & black) != 1)
+        return false;
+
+    if (pawns & 0xFF000000000000FFull)
+        return false;
+
+    // move and undo_move expect the rook of every castling right to be there
+    bool white_king_home = kings & white & (1ull << 4);
+    bool black_king_home = kings & black & (1ull << 60);
+    if ((castlings & castle_white_short_bits) && !(white_king_home && (rooks & white & (1ull << 7))))
+        return false;
+    if ((castlings & castle_white_long_bits) && !(white_king_home && (rooks & white & (1ull << 0))))
+        return false;
+    if ((castlings & castle_black_short_bits) && !(black_king_home && (rooks & black & (1ull << 63))))
+        return false;
+    if ((castlings & castle_black_long_bits) && !(black_king_home && (rooks & black & (1ull << 56))))
+        return false;
+
+    // the en-passant square is empty and the pawn of the side that just moved stands right in front of it
+    if (en_passant != ep_empty)
     {
-        if (is_rook_left_attacked(opp_rook_mask, mask_blockers, pos))
-            return true;
-        if (is_rook_right_attacked(opp_rook_mask, mask_blockers, pos))
-            return true;
-        if (is_rook_up_attacked(opp_rook_mask, mask_blockers, pos))
-            return true;
-        if (is_rook_down_attacked(opp_rook_mask, mask_blockers, pos))
-            return true;
+        uint32_t ep_row = white_to_move ? 5 : 2;
+        uint32_t pawn_pos = white_to_move ? en_passant - 8 : en_passant + 8;
+        board_t opponent = white_to_move ? black : white;
+        if (en_passant / 8 != ep_row || ((white | black) & (1ull << en_passant)) || !(pawns & opponent & (1ull << pawn_pos)))
+            return false;
     }
 
-    // Queen's and Bishop's attacks
-    board_t opp_bishop_mask = opp & (queens | bishops);
-    mask_blockers = (black | white) & ~opp_bishop_mask;
+    return !is_attacked(get_king_pos(!white_to_move), !white_to_move);
+}
 
-    if (opp_bishop_mask & attacking_mask_bishop[pos])
-    {
-        if (is_bishop_left_down_attacked(opp_bishop_mask, mask_blockers, pos))
-            return true;
-        if (is_bishop_left_up_attacked(opp_bishop_mask, mask_blockers, pos))
-            return true;
-        if (is_bishop_right_down_attacked(opp_bishop_mask, mask_blockers, pos))
-            return true;
-        if (is_bishop_right_up_attacked(opp_bishop_mask, mask_blockers, pos))
-            return true;
-    }
+// https://www.chessprogramming.org/SEE_-_The_Swap_Algorithm
+int ChessBoard::see(move_t chess_move)
+{
+    square_t pos_from = get_move_from(chess_move);
+    square_t pos_to = get_move_to(chess_move);
 
-    // Knight's attacks
-    if (opp & attacking_mask_knight[pos] & knights)
-        return true;
+    // gain[d] is what the side making the d-th capture wins if the exchange stops after it
+    int gain[32];
+    int depth = 0;
 
-    // King's attacks
-    if (opp_king_attacking_mask & (1ull << pos))
-        return true;
+    board_t occupied = white | black;
+    board_t from_bit = 1ull << pos_from;
+    int attacker_value = see_values[(int)get_piece_type(pos_from) % 8];
 
-    // Pawn's attacks
-    int pos_row = pos / 8;
-    int pos_col = pos % 8;
+    gain[0] = see_values[(int)get_piece_type(pos_to) % 8];
 
-    if (white_move) {
-        if (pos_row < 7 && pos_col < 7 && is_piece(opp & pawns, pos + 9))
-            return true;
-        if (pos_row < 7 && pos_col > 0 && is_piece(opp & pawns, pos + 7))
-            return true;
-    }
-    else
+    // en-passant, the captured pawn doesn't stand on the target square
+    if (is_en_passant_takeover(chess_move))
     {
-        if (pos_row > 0 && pos_col < 7 && is_piece(opp & pawns, pos - 7))
-            return true;
-        if (pos_row > 0 && pos_col > 0 && is_piece(opp & pawns, pos - 9))
-            return true;
+        gain[0] = see_values[(int)piece_no_color_t::pawn];
+        occupied ^= 1ull << (white_to_move ? pos_to - 8 : pos_to + 8);
     }
 
-    return false;
-}
-
-bool ChessBoard::in_check()
-{
-    color_mask = white_to_move ? white : black;
-    king_pos = bit_pos(color_mask & kings);
-    return is_attacked(king_pos, white_to_move);
-}
-
-vector<move_t> ChessBoard::generate_moves()
-{
-    vector<move_t> valid_moves;
-    vector<move_t> candidate_moves;
-
-    valid_moves.reserve(128);
-
-    color_mask = white_to_move ? white : black;
-    opp_color_mask = white_to_move ? black : white;
-    board_t b;
-
-    king_pos = bit_pos(color_mask & kings);
-    king_pos_row = get_row(king_pos);
-    king_pos_col = get_col(king_pos);
+    piece_t promotion = get_promotion(chess_move);
+    if (promotion != piece_t::empty)
+    {
+        gain[0] += see_values[(int)promotion % 8] - see_values[(int)piece_no_color_t::pawn];
+        attacker_value = see_values[(int)promotion % 8];
+    }
 
-    opp_king_pos = bit_pos((white_to_move ? black : white) & kings);
-    opp_king_attacking_mask = attacking_mask_king[opp_king_pos];
-    piece_color = white_to_move ? color_t::white : color_t::black;
+    // sliders behind a piece that has captured (x-rays) are added when the piece leaves the line
+    board_t diagonal_sliders = bishops | queens;
+    board_t straight_sliders = rooks | queens;
+    board_t attackers = attackers_to(pos_to, occupied);
+    bool white_side = white_to_move;
 
-    b_attacking_queens = attacking_mask_queen[king_pos];
-    b_attacking_rooks = attacking_mask_rook[king_pos];
-    b_attacking_bishops = attacking_mask_bishop[king_pos];
-    b_need_inspection = attacking_mask_queen[king_pos];
+    // the pieces that can recapture, from the least valuable
+    const board_t least_valuable_order[6] = { pawns, knights, bishops, rooks, queens, kings };
+    const piece_no_color_t least_valuable_pieces[6] = { piece_no_color_t::pawn, piece_no_color_t::knight, piece_no_color_t::bishop,
+        piece_no_color_t::rook, piece_no_color_t::queen, piece_no_color_t::king };
 
-    all_safe = !(opp_color_mask & (queens | rooks | bishops));
+    while (from_bit)
+    {
+        depth++;
+        gain[depth] = attacker_value - gain[depth - 1];
 
-    if (white_to_move)
-        king_in_check = white_in_check = is_attacked(king_pos, true);
-    else
-        king_in_check = black_in_check = is_attacked(king_pos, false);
+        // neither side can win anything by continuing
+        if (max(-gain[depth - 1], gain[depth]) < 0)
+            break;
 
-    if (king_in_check)
-        candidate_moves.reserve(64);
+        occupied ^= from_bit;
+        attackers |= (bishop_attacks(pos_to, occupied) & diagonal_sliders) | (rook_attacks(pos_to, occupied) & straight_sliders);
+        attackers &= occupied;
 
+        white_side = !white_side;
+        board_t side_attackers = attackers & (white_side ? white : black);
 
-    if (white_to_move)
-    {
-        b = pawns & color_mask;
-        switch (__popcnt64(pawns & color_mask))
-        {
-        case 8:
-            generate_pawn_white_moves(valid_moves, candidate_moves, bit_pos(b));
-            b &= b - 1;
-        case 7:
-            generate_pawn_white_moves(valid_moves, candidate_moves, bit_pos(b));
-            b &= b - 1;
-        case 6:
-            generate_pawn_white_moves(valid_moves, candidate_moves, bit_pos(b));
-            b &= b - 1;
-        case 5:
-            generate_pawn_white_moves(valid_moves, candidate_moves, bit_pos(b));
-            b &= b - 1;
-        case 4:
-            generate_pawn_white_moves(valid_moves, candidate_moves, bit_pos(b));
-            b &= b - 1;
-        case 3:
-            generate_pawn_white_moves(valid_moves, candidate_moves, bit_pos(b));
-            b &= b - 1;
-        case 2:
-            generate_pawn_white_moves(valid_moves, candidate_moves, bit_pos(b));
-            b &= b - 1;
-        case 1:
-            generate_pawn_white_moves(valid_moves, candidate_moves, bit_pos(b));
-            b &= b - 1;
-        }
-    }
-    else
-    {
-        b = pawns & color_mask;
-        switch (__popcnt64(pawns & color_mask))
+        from_bit = 0;
+        for (int i = 0; i < 6; i++)
         {
-        case 8:
-            generate_pawn_black_moves(valid_moves, candidate_moves, bit_pos(b));
-            b &= b - 1;
-        case 7:
-            generate_pawn_black_moves(valid_moves, candidate_moves, bit_pos(b));
-            b &= b - 1;
-        case 6:
-            generate_pawn_black_moves(valid_moves, candidate_moves, bit_pos(b));
-            b &= b - 1;
-        case 5:
-            generate_pawn_black_moves(valid_moves, candidate_moves, bit_pos(b));
-            b &= b - 1;
-        case 4:
-            generate_pawn_black_moves(valid_moves, candidate_moves, bit_pos(b));
-            b &= b - 1;
-        case 3:
-            generate_pawn_black_moves(valid_moves, candidate_moves, bit_pos(b));
-            b &= b - 1;
-        case 2:
-            generate_pawn_black_moves(valid_moves, candidate_moves, bit_pos(b));
-            b &= b - 1;
-        case 1:
-            generate_pawn_black_moves(valid_moves, candidate_moves, bit_pos(b));
-            b &= b - 1;
+            board_t pieces = side_attackers & least_valuable_order[i];
+            if (pieces)
+            {
+                from_bit = pieces & (0 - pieces);
+                attacker_value = see_values[(int)least_valuable_pieces[i]];
+                break;
+            }
         }
     }
 
-    generate_king_all_moves(valid_moves, candidate_moves, bit_pos(kings & color_mask));
-
-    for (b = bishops & color_mask; b; b &= b - 1)
-        generate_bishop_all_moves(piece_no_color_t::bishop, valid_moves, candidate_moves, bit_pos(b));
-
-    for (b = rooks & color_mask; b; b &= b - 1)
-        generate_rook_all_moves(piece_no_color_t::rook, valid_moves, candidate_moves, bit_pos(b));
-
-    for (b = queens & color_mask; b; b &= b - 1)
-        generate_queen_all_moves(valid_moves, candidate_moves, bit_pos(b));
+    while (--depth)
+        gain[depth - 1] = -max(-gain[depth - 1], gain[depth]);
 
-    for (b = knights & color_mask; b; b &= b - 1)
-        generate_knight_all_moves(valid_moves, candidate_moves, bit_pos(b));
+    return gain[0];
+}
 
-    add_en_passant(valid_moves, candidate_moves);
+vector<move_t> ChessBoard::generate_moves()
+{
+    MoveList valid_moves;
+    generate_moves(valid_moves);
 
-    if (!king_in_check)
-        add_castleing(valid_moves, candidate_moves);
+    return vector<move_t>(valid_moves.begin(), valid_moves.end());
+}
 
-    valid_moves.reserve(valid_moves.size() + candidate_moves.size());
+void ChessBoard::generate_moves(MoveList& valid_moves)
+{
+    generate(valid_moves, move_gen_t::all);
+}
 
-    int king_pos = bit_pos(kings & color_mask);
-    int king_pos_row = get_row(king_pos);
-    int king_pos_col = get_col(king_pos);
+vector<move_t> ChessBoard::generate_capture_moves()
+{
+    MoveList valid_moves;
+    generate_capture_moves(valid_moves);
 
-    for (const move_t& move_ : candidate_moves) {
-        move(move_);
-        white_to_move = !white_to_move;
-        if (!in_check()) {
-            valid_moves.push_back(move_);
-        }
+    return vector<move_t>(valid_moves.begin(), valid_moves.end());
+}
 
-        white_to_move = !white_to_move;
-        undo_move();
-    }
+void ChessBoard::generate_capture_moves(MoveList& valid_moves)
+{
+    generate(valid_moves, move_gen_t::captures);
+}
 
-    return valid_moves;
+void ChessBoard::generate_quiet_moves(MoveList& valid_moves)
+{
+    generate(valid_moves, move_gen_t::quiets);
 }
 
-vector<move_t> ChessBoard::generate_capture_moves()
+bool ChessBoard::is_move_legal(move_t chess_move)
 {
-    vector<move_t> valid_moves;
-    vector<move_t> candidate_moves;
+    square_t pos_from = get_move_from(chess_move);
+    piece_no_color_t moving_piece = get_moving_piece(chess_move);
+    piece_t piece = get_piece_type(pos_from);
 
-    valid_moves.reserve(64);
+    if (piece == piece_t::empty || moving_piece == piece_no_color_t::empty)
+        return false;
 
-    color_mask = white_to_move ? white : black;
-    opp_color_mask = white_to_move ? black : white;
-    board_t b;
+    if ((piece_no_color_t)((int)piece % 8) != moving_piece || is_square_white(pos_from) != white_to_move)
+        return false;
 
-    king_pos = bit_pos(color_mask & kings);
-    king_pos_row = get_row(king_pos);
-    king_pos_col = get_col(king_pos);
+    // only the moves of the piece on the starting square are generated
+    MoveList moves;
+    init_legality_masks();
+
+    switch (moving_piece)
+    {
+    case piece_no_color_t::pawn:
+        if (white_to_move)
+            generate_pawn_white_moves(moves, pos_from, move_gen_t::all);
+        else
+            generate_pawn_black_moves(moves, pos_from, move_gen_t::all);
+        add_en_passant(moves);
+        break;
+    case piece_no_color_t::knight:
+        generate_knight_moves(moves, pos_from, ~color_mask);
+        break;
+    case piece_no_color_t::bishop:
+        generate_bishop_moves(piece_no_color_t::bishop, moves, pos_from, ~color_mask);
+        break;
+    case piece_no_color_t::rook:
+        generate_rook_moves(piece_no_color_t::rook, moves, pos_from, ~color_mask);
+        break;
+    case piece_no_color_t::queen:
+        generate_queen_moves(moves, pos_from, ~color_mask);
+        break;
+    case piece_no_color_t::king:
+        generate_king_moves(moves, pos_from, ~color_mask);
+        if (!king_in_check)
+            add_castleing(moves);
+        break;
+    default:
+        break;
+    }
 
-    opp_king_pos = bit_pos((white_to_move ? black : white) & kings);
-    opp_king_attacking_mask = attacking_mask_king[opp_king_pos];
-    piece_color = white_to_move ? color_t::white : color_t::black;
+    return find(moves.begin(), moves.end(), chess_move) != moves.end();
+}
 
-    b_attacking_queens = attacking_mask_queen[king_pos];
-    b_attacking_rooks = attacking_mask_rook[king_pos];
-    b_attacking_bishops = attacking_mask_bishop[king_pos];
-    b_need_inspection = attacking_mask_queen[king_pos];
+void ChessBoard::generate(MoveList& valid_moves, move_gen_t gen)
+{
+    valid_moves.clear();
 
-    all_safe = !(opp_color_mask & (queens | rooks | bishops));
+    init_legality_masks();
 
-    if (white_to_move)
-        king_in_check = white_in_check = is_attacked(king_pos, true);
-    else
-        king_in_check = black_in_check = is_attacked(king_pos, false);
+    board_t targets = ~color_mask;
+    if (gen == move_gen_t::captures)
+        targets = opp_color_mask;
+    else if (gen == move_gen_t::quiets)
+        targets = ~(white | black);
+    board_t b;
 
+    // when in check the king moves go first (in a double check they are the only legal moves)
     if (king_in_check)
-        candidate_moves.reserve(32);
+        generate_king_moves(valid_moves, king_pos, targets);
 
+    if (!check_mask)
+        return;
 
     if (white_to_move)
     {
-        b = pawns & color_mask;
-        switch (__popcnt64(pawns & color_mask))
-        {
-        case 8:
-            generate_pawn_white_moves(valid_moves, candidate_moves, bit_pos(b), true);
-            b &= b - 1;
-        case 7:
-            generate_pawn_white_moves(valid_moves, candidate_moves, bit_pos(b), true);
-            b &= b - 1;
-        case 6:
-            generate_pawn_white_moves(valid_moves, candidate_moves, bit_pos(b), true);
-            b &= b - 1;
-        case 5:
-            generate_pawn_white_moves(valid_moves, candidate_moves, bit_pos(b), true);
-            b &= b - 1;
-        case 4:
-            generate_pawn_white_moves(valid_moves, candidate_moves, bit_pos(b), true);
-            b &= b - 1;
-        case 3:
-            generate_pawn_white_moves(valid_moves, candidate_moves, bit_pos(b), true);
-            b &= b - 1;
-        case 2:
-            generate_pawn_white_moves(valid_moves, candidate_moves, bit_pos(b), true);
-            b &= b - 1;
-        case 1:
-            generate_pawn_white_moves(valid_moves, candidate_moves, bit_pos(b), true);
-            b &= b - 1;
-        }
+        for (b = pawns & color_mask; b; b &= b - 1)
+            generate_pawn_white_moves(valid_moves, bit_pos(b), gen);
     }
     else
     {
-        b = pawns & color_mask;
-        switch (__popcnt64(pawns & color_mask))
-        {
-        case 8:
-            generate_pawn_black_moves(valid_moves, candidate_moves, bit_pos(b), true);
-            b &= b - 1;
-        case 7:
-            generate_pawn_black_moves(valid_moves, candidate_moves, bit_pos(b), true);
-            b &= b - 1;
-        case 6:
-            generate_pawn_black_moves(valid_moves, candidate_moves, bit_pos(b), true);
-            b &= b - 1;
-        case 5:
-            generate_pawn_black_moves(valid_moves, candidate_moves, bit_pos(b), true);
-            b &= b - 1;
-        case 4:
-            generate_pawn_black_moves(valid_moves, candidate_moves, bit_pos(b), true);
-            b &= b - 1;
-        case 3:
-            generate_pawn_black_moves(valid_moves, candidate_moves, bit_pos(b), true);
-            b &= b - 1;
-        case 2:
-            generate_pawn_black_moves(valid_moves, candidate_moves, bit_pos(b), true);
-            b &= b - 1;
-        case 1:
-            generate_pawn_black_moves(valid_moves, candidate_moves, bit_pos(b), true);
-            b &= b - 1;
-        }
+        for (b = pawns & color_mask; b; b &= b - 1)
+            generate_pawn_black_moves(valid_moves, bit_pos(b), gen);
     }
 
-    generate_king_capture_moves(valid_moves, candidate_moves, bit_pos(kings & color_mask));
+    if (!king_in_check)
+        generate_king_moves(valid_moves, king_pos, targets);
 
     for (b = bishops & color_mask; b; b &= b - 1)
-        generate_bishop_capture_moves(piece_no_color_t::bishop, valid_moves, candidate_moves, bit_pos(b));
+        generate_bishop_moves(piece_no_color_t::bishop, valid_moves, bit_pos(b), targets);
 
     for (b = rooks & color_mask; b; b &= b - 1)
-        generate_rook_capture_moves(piece_no_color_t::rook, valid_moves, candidate_moves, bit_pos(b));
+        generate_rook_moves(piece_no_color_t::rook, valid_moves, bit_pos(b), targets);
 
     for (b = queens & color_mask; b; b &= b - 1)
-        generate_queen_capture_moves(valid_moves, candidate_moves, bit_pos(b));
+        generate_queen_moves(valid_moves, bit_pos(b), targets);
 
     for (b = knights & color_mask; b; b &= b - 1)
-        generate_knight_capture_moves(valid_moves, candidate_moves, bit_pos(b));
-
-    add_en_passant(valid_moves, candidate_moves);
-
-    valid_moves.reserve(valid_moves.size() + candidate_moves.size());
+        generate_knight_moves(valid_moves, bit_pos(b), targets);
 
-    int king_pos = bit_pos(kings & color_mask);
-    int king_pos_row = get_row(king_pos);
-    int king_pos_col = get_col(king_pos);
+    if (gen != move_gen_t::quiets)
+        add_en_passant(valid_moves);
 
-    for (const move_t& move_ : candidate_moves) {
-        move(move_);
-        white_to_move = !white_to_move;
-        if (!in_check()) {
-            valid_moves.push_back(move_);
-        }
-
-        white_to_move = !white_to_move;
-        undo_move();
-    }
-
-    return valid_moves;
+    if (gen != move_gen_t::captures && !king_in_check)
+        add_castleing(valid_moves);
 }
 
 void ChessBoard::move(move_t move)
 {
-    piece_t takeover = get_piece_type(get_move_to(move));
+    auto pos_from = get_move_from(move);
+    auto pos_to = get_move_to(move);
+
+    piece_t takeover = mailbox[pos_to];
     piece_no_color_t moving_piece = get_moving_piece(move);
     piece_t moving_piece_color = (piece_t)((unsigned)moving_piece + 8 * !white_to_move);
 
@@ -1117,10 +780,10 @@ void ChessBoard::move(move_t move)
 
     move_log.push_back(encode_move_log(move, takeover, castlings, en_passant, last_pawn_move));
 
-    auto pos_from = get_move_from(move);
-    auto pos_to = get_move_to(move);
+    hash_key ^= state_key();
 
-    if (moving_piece == piece_no_color_t::pawn)
+    // pawn moves and captures can't be undone so no position before them can repeat
+    if (moving_piece == piece_no_color_t::pawn || takeover != piece_t::empty)
         last_pawn_move = 0;
     else
         last_pawn_move += 1;
@@ -1130,20 +793,20 @@ void ChessBoard::move(move_t move)
             reset_castlings(castle_white_long_bits | castle_white_short_bits);
 
             if (pos_from + 2 == pos_to) {
-                bit_move(white, rooks, 7, 5);
+                move_piece(7, 5);
             }
             else if (pos_from == pos_to + 2) {
-                bit_move(white, rooks, 0, 3);
+                move_piece(0, 3);
             }
         }
         else {
             reset_castlings(castle_black_long_bits | castle_black_short_bits);
 
             if (pos_from + 2 == pos_to) {
-                bit_move(black, rooks, 63, 61);
+                move_piece(63, 61);
             }
             else if (pos_from == pos_to + 2) {
-                bit_move(black, rooks, 56, 59);
+                move_piece(56, 59);
             }
         }
     }
@@ -1163,11 +826,11 @@ void ChessBoard::move(move_t move)
         piece_t promotion = get_promotion(move);
 
         if (promotion != piece_t::empty) {
-            bit_reset(white_to_move ? white : black, pawns, pos_from);
+            reset_piece(pos_from);
 
             if (takeover != piece_t::empty)
             {
-                bit_reset(white_to_move ? black : white, *boards[(int)takeover], pos_to);
+                reset_piece(pos_to);
 
                 if (pos_to == 7)
                     reset_castlings(castle_white_short_bits);
@@ -1179,10 +842,11 @@ void ChessBoard::move(move_t move)
                     reset_castlings(castle_black_long_bits);
             }
 
-            bit_set(white_to_move ? white : black, *boards[(int)promotion], pos_to);
+            set_piece(promotion, pos_to);
 
             white_to_move = !white_to_move;
             en_passant = ep_empty;
+            hash_key ^= state_key();
 
             test_board();
 
@@ -1190,7 +854,7 @@ void ChessBoard::move(move_t move)
         }
 
         if (en_passant != ep_empty && en_passant == pos_to) {
-            bit_reset(white_to_move ? black : white, pawns, white_to_move ? pos_to - 8 : pos_to + 8);
+            reset_piece(white_to_move ? pos_to - 8 : pos_to + 8);
         }
     }
 
@@ -1203,7 +867,7 @@ void ChessBoard::move(move_t move)
 
     if (takeover != piece_t::empty)
     {
-        bit_reset(white_to_move ? black : white, *boards[(int)takeover], pos_to);
+        reset_piece(pos_to);
 
         if (pos_to == 7)
             reset_castlings(castle_white_short_bits);
@@ -1215,29 +879,10 @@ void ChessBoard::move(move_t move)
             reset_castlings(castle_black_long_bits);
     }
 
-    switch (moving_piece)
-    {
-    case piece_no_color_t::pawn:
-        bit_move(white_to_move ? white : black, pawns, pos_from, pos_to);
-        break;
-    case piece_no_color_t::bishop:
-        bit_move(white_to_move ? white : black, bishops, pos_from, pos_to);
-        break;
-    case piece_no_color_t::knight:
-        bit_move(white_to_move ? white : black, knights, pos_from, pos_to);
-        break;
-    case piece_no_color_t::rook:
-        bit_move(white_to_move ? white : black, rooks, pos_from, pos_to);
-        break;
-    case piece_no_color_t::queen:
-        bit_move(white_to_move ? white : black, queens, pos_from, pos_to);
-        break;
-    case piece_no_color_t::king:
-        bit_move(white_to_move ? white : black, kings, pos_from, pos_to);
-        break;
-    }
+    move_piece(pos_from, pos_to);
 
     white_to_move = !white_to_move;
+    hash_key ^= state_key();
 
     test_board();
 }
@@ -1246,8 +891,13 @@ void ChessBoard::no_move()
 {
     move_log.push_back(encode_move_log(0, piece_t::empty, castlings, en_passant, last_pawn_move));
 
+    hash_key ^= state_key();
     en_passant = ep_empty;
     white_to_move = !white_to_move;
+    hash_key ^= state_key();
+
+    // the positions before a null move aren't reachable in a real game, so repetition detection has to stop here
+    last_pawn_move = 0;
 }
 
 void ChessBoard::undo_move() {
@@ -1259,6 +909,8 @@ void ChessBoard::undo_move() {
     move_t move = (move_t)(move_ & 0xffffffffull);
     move_log.pop_back();
 
+    hash_key ^= state_key();
+
     castlings = get_castlings(move);
     en_passant = get_ep(move);
 
@@ -1271,6 +923,8 @@ void ChessBoard::undo_move() {
 
     white_to_move = !white_to_move;
 
+    hash_key ^= state_key();
+
     if (pos_from == 0 && pos_to == 0)        // no-move
         return;
 
@@ -1281,68 +935,40 @@ void ChessBoard::undo_move() {
     if (moving_piece == piece_no_color_t::king) {
         if (white_to_move) {
             if (pos_from + 2 == pos_to) {
-                bit_move(white, rooks, 5, 7);
+                move_piece(5, 7);
             }
             else if (pos_from == pos_to + 2) {
-                bit_move(white, rooks, 3, 0);
+                move_piece(3, 0);
             }
         }
         else {
             if (pos_from + 2 == pos_to) {
-                bit_move(black, rooks, 61, 63);
+                move_piece(61, 63);
             }
             else if (pos_from == pos_to + 2) {
-                bit_move(black, rooks, 59, 56);
+                move_piece(59, 56);
             }
         }
     }
     else if (promotion != piece_t::empty) {
-        if (pos_to >= 56)
-            bit_set(white, pawns, pos_from);
-        else
-            bit_set(black, pawns, pos_from);
-
-        bit_reset(white_to_move ? white : black, *boards[(int)promotion], pos_to);
+        reset_piece(pos_to);
+        set_piece(white_to_move ? piece_t::white_pawn : piece_t::black_pawn, pos_from);
 
         if (takeover != piece_t::empty)
-            bit_set(white_to_move ? black : white, *boards[(int)takeover], pos_to);
+            set_piece(takeover, pos_to);
 
         test_board();
 
         return;
     }
 
-    if (en_passant != ep_empty && en_passant == pos_to) {
-        if (is_white_pawn(pos_to))
-            bit_set(black, pawns, pos_to - 8);
-        else if (is_black_pawn(pos_to))
-            bit_set(white, pawns, pos_to + 8);
-    }
+    move_piece(pos_to, pos_from);
 
-    switch (moving_piece)
-    {
-    case piece_no_color_t::pawn:
-        bit_move(white_to_move ? white : black, pawns, pos_to, pos_from);
-        break;
-    case piece_no_color_t::bishop:
-        bit_move(white_to_move ? white : black, bishops, pos_to, pos_from);
-        break;
-    case piece_no_color_t::knight:
-        bit_move(white_to_move ? white : black, knights, pos_to, pos_from);
-        break;
-    case piece_no_color_t::rook:
-        bit_move(white_to_move ? white : black, rooks, pos_to, pos_from);
-        break;
-    case piece_no_color_t::queen:
-        bit_move(white_to_move ? white : black, queens, pos_to, pos_from);
-        break;
-    case piece_no_color_t::king:
-        bit_move(white_to_move ? white : black, kings, pos_to, pos_from);
-        break;
-    }
+    if (moving_piece == piece_no_color_t::pawn && en_passant != ep_empty && en_passant == pos_to)
+        set_piece(white_to_move ? piece_t::black_pawn : piece_t::white_pawn, white_to_move ? pos_to - 8 : pos_to + 8);
 
     if (takeover != piece_t::empty)
-        bit_set(white_to_move ? black : white, *boards[(int)takeover], pos_to);
+        set_piece(takeover, pos_to);
 
     test_board();
 }
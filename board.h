@@ -7,13 +7,16 @@
 #include <array>
 #include <vector>
 #include <tuple>
-#include "board.h"
+#include "attacks.h"
+#include "zobrist.h"
+#include "piece_square_tables.h"
 
 #include <intrin.h>
 
 using namespace std;
 
-enum class piece_t {
+// uint8_t so the mailbox takes a single byte per square
+enum class piece_t : uint8_t {
     empty = 0,
     white_king = 1,
     white_pawn = 2,
@@ -44,6 +47,14 @@ enum class color_t {
     white = 1,
     black = 2
 };
+
+// which moves the generator produces
+// captures are captures (including capture promotions and en-passant), quiets are all the other moves
+enum class move_gen_t {
+    all = 0,
+    captures = 1,
+    quiets = 2
+};
 // move_t is used to represent a move
 // bits 0-5 represent the starting position of moveing piece
 // bits 6-11 represent the end position of moveing piece
@@ -68,155 +79,100 @@ using move_log_t = uint64_t;
 // board_t is a bitboard where each bit represents whether or not a square is occupied
 using board_t = uint64_t;
 
-#define null_move board.encode_move(piece_no_color_t::empty, 0, 0)
-
-// class used to store the currrent position simmilar to fen notation
-// its used as a key in a dictionary for transpositions
-// sience its faster to generate than fen strings
-struct board_state_t
+// fixed capacity list of moves used instead of vector<move_t> during move generation and search
+// it lives on the stack so generating moves doesn't allocate memory
+// no legal chess position has more than 218 moves so 256 is always enough
+struct MoveList
 {
-    const uint32_t ep_shift = 20;
-    const uint32_t castling_shift = 25;
-    const uint32_t meta_shift = 32;
-    const uint32_t turn_shift = 31;
-
-    const uint64_t ep_mask = 0x1full;
-    const uint64_t castling_mask = 0xfull;
-    const uint64_t user_mask = 0x7fffffffull;
-
-    const uint64_t ep_empty = 32;
-
-    uint64_t white;
-    uint64_t black;
-    uint64_t kings;
-    uint64_t queens;
-    uint64_t rooks;
-    uint64_t bishops;
-    uint64_t knights;
-    uint64_t pawns;
-    uint64_t metadata;
-
-    board_state_t() = default;
-    board_state_t(const board_state_t&) = default;
-    board_state_t& operator=(const board_state_t& x)
-    {
-        if (this == &x)
-            return *this;
-
-        this->white = x.white;
-        this->black = x.black;
-        this->kings = x.kings;
-        this->queens = x.queens;
-        this->rooks = x.rooks;
-        this->bishops = x.bishops;
-        this->knights = x.knights;
-        this->pawns = x.pawns;
-        this->metadata = x.metadata;
+    static const uint32_t capacity = 256;
 
-        return *this;
-    };
+    move_t moves[capacity];
+    uint32_t count = 0;
 
-    unsigned get_ep() const
+    void push_back(move_t chess_move)
     {
-        auto x = ((metadata >> (meta_shift + ep_shift)) & ep_mask) + 16;
-
-        if (x == ep_empty)
-            return 0;
-
-        return (unsigned)x;
+        moves[count++] = chess_move;
     }
 
-    unsigned get_castlings() const
+    void emplace_back(move_t chess_move)
     {
-        return (unsigned)((metadata >> (meta_shift + castling_shift)) & castling_mask);
+        moves[count++] = chess_move;
     }
 
-    unsigned get_user_data() const
+    void clear()
     {
-        return (unsigned)(metadata & user_mask);
+        count = 0;
     }
 
-    // true - white turn
-    // false - black turn
-    bool get_turn() const
+    size_t size() const
     {
-        return (bool)((metadata >> turn_shift) & 1);
+        return count;
     }
 
-    bool operator==(const board_state_t& x) const
+    bool empty() const
     {
-        return
-            white == x.white &&
-            black == x.black &&
-            kings == x.kings &&
-            queens == x.queens &&
-            rooks == x.rooks &&
-            bishops == x.bishops &&
-            knights == x.knights &&
-            pawns == x.pawns &&
-            metadata == x.metadata;
+        return count == 0;
     }
 
-    bool operator!=(const board_state_t& x) const
+    move_t& operator[](size_t index)
     {
-        return !operator==(x);
+        return moves[index];
     }
 
-    // returns true if a piece at pos is on bitboard b
-    constexpr bool is_piece(board_t b, square_t pos)
+    move_t operator[](size_t index) const
     {
-        return b & (1ull << pos);
+        return moves[index];
     }
 
-    // returns true if a white piece is on square pos
-    constexpr bool is_square_white(square_t pos)
+    move_t* begin()
     {
-        return white & (1ull << pos);
+        return moves;
     }
 
-    // returns false if a black piece is on square pos
-    constexpr bool is_square_black(square_t pos)
+    move_t* end()
     {
-        return black & (1ull << pos);
+        return moves + count;
     }
 
-    piece_t get_piece_type(square_t pos)
+    const move_t* begin() const
     {
-        if (is_square_white(pos))
-        {
-            if (is_piece(pawns, pos))
-                return piece_t::white_pawn;
-            if (is_piece(knights, pos))
-                return piece_t::white_knight;
-            if (is_piece(bishops, pos))
-                return piece_t::white_bishop;
-            if (is_piece(rooks, pos))
-                return piece_t::white_rook;
-            if (is_piece(queens, pos))
-                return piece_t::white_queen;
-            if (is_piece(kings, pos))
-                return piece_t::white_king;
-        }
-        else if (is_square_black(pos))
-        {
-            if (is_piece(pawns, pos))
-                return piece_t::black_pawn;
-            if (is_piece(knights, pos))
-                return piece_t::black_knight;
-            if (is_piece(bishops, pos))
-                return piece_t::black_bishop;
-            if (is_piece(rooks, pos))
-                return piece_t::black_rook;
-            if (is_piece(queens, pos))
-                return piece_t::black_queen;
-            if (is_piece(kings, pos))
-                return piece_t::black_king;
-        }
+        return moves;
+    }
 
-        return piece_t::empty;
+    const move_t* end() const
+    {
+        return moves + count;
     }
 };
 
+#define null_move board.encode_move(piece_no_color_t::empty, 0, 0)
+
+// plain copy of everything needed to restore a position (96 bytes)
+// search saves one before a move and copies it back instead of decoding the move log in undo_move
+// https://www.chessprogramming.org/Copy-Make
+struct Position
+{
+    board_t white;
+    board_t black;
+    board_t kings;
+    board_t queens;
+    board_t rooks;
+    board_t bishops;
+    board_t knights;
+    board_t pawns;
+
+    uint64_t hash_key;
+    uint64_t pawn_key;
+
+    score_t piece_square_score;
+    uint8_t endgame_material[2];
+
+    uint8_t castlings;
+    uint8_t en_passant;
+    uint16_t last_pawn_move;
+    bool white_to_move;
+};
+
 class ChessBoard {
 
     const static uint32_t move_shift = 0;
@@ -237,6 +193,7 @@ class ChessBoard {
 
     const static move_t half_move_mask = 0x3fu;
     const static move_t full_move_mask = 0xfffu;
+    const static move_t short_move_mask = 0xffffu;
     const static move_t ep_mask = 0x1fu;
     const static move_t piece_mask = 0xfu;
     const static move_t moving_piece_mask = 0xfu;
@@ -248,697 +205,43 @@ class ChessBoard {
     const static move_t castling_mask = 0xfu;
     const static move_t castle_mask = 1u;
 
+    // piece values of the static exchange evaluation indexed by piece_no_color_t, the king can only recapture as the last piece
+    static constexpr int see_values[8] = { 0, 20'000, 100, 300, 325, 500, 900, 0 };
 
-    /*
-    to speed up move generation moves are precomputed for each piece exept pawns.
-    rooks, bishops and queens movement is also split in to moves for every direction.
-    sience every method used is constexpr the values are computed at compile time
-    */
-    board_t attacking_mask_king[64] = {
-        king_am(0, 0), king_am(0, 1), king_am(0, 2), king_am(0, 3), king_am(0, 4), king_am(0, 5), king_am(0, 6), king_am(0, 7),
-        king_am(1, 0), king_am(1, 1), king_am(1, 2), king_am(1, 3), king_am(1, 4), king_am(1, 5), king_am(1, 6), king_am(1, 7),
-        king_am(2, 0), king_am(2, 1), king_am(2, 2), king_am(2, 3), king_am(2, 4), king_am(2, 5), king_am(2, 6), king_am(2, 7),
-        king_am(3, 0), king_am(3, 1), king_am(3, 2), king_am(3, 3), king_am(3, 4), king_am(3, 5), king_am(3, 6), king_am(3, 7),
-        king_am(4, 0), king_am(4, 1), king_am(4, 2), king_am(4, 3), king_am(4, 4), king_am(4, 5), king_am(4, 6), king_am(4, 7),
-        king_am(5, 0), king_am(5, 1), king_am(5, 2), king_am(5, 3), king_am(5, 4), king_am(5, 5), king_am(5, 6), king_am(5, 7),
-        king_am(6, 0), king_am(6, 1), king_am(6, 2), king_am(6, 3), king_am(6, 4), king_am(6, 5), king_am(6, 6), king_am(6, 7),
-        king_am(7, 0), king_am(7, 1), king_am(7, 2), king_am(7, 3), king_am(7, 4), king_am(7, 5), king_am(7, 6), king_am(7, 7)
-    };
-
-    board_t attacking_mask_knight[64] = {
-        knight_am(0, 0), knight_am(0, 1), knight_am(0, 2), knight_am(0, 3), knight_am(0, 4), knight_am(0, 5), knight_am(0, 6), knight_am(0, 7),
-        knight_am(1, 0), knight_am(1, 1), knight_am(1, 2), knight_am(1, 3), knight_am(1, 4), knight_am(1, 5), knight_am(1, 6), knight_am(1, 7),
-        knight_am(2, 0), knight_am(2, 1), knight_am(2, 2), knight_am(2, 3), knight_am(2, 4), knight_am(2, 5), knight_am(2, 6), knight_am(2, 7),
-        knight_am(3, 0), knight_am(3, 1), knight_am(3, 2), knight_am(3, 3), knight_am(3, 4), knight_am(3, 5), knight_am(3, 6), knight_am(3, 7),
-        knight_am(4, 0), knight_am(4, 1), knight_am(4, 2), knight_am(4, 3), knight_am(4, 4), knight_am(4, 5), knight_am(4, 6), knight_am(4, 7),
-        knight_am(5, 0), knight_am(5, 1), knight_am(5, 2), knight_am(5, 3), knight_am(5, 4), knight_am(5, 5), knight_am(5, 6), knight_am(5, 7),
-        knight_am(6, 0), knight_am(6, 1), knight_am(6, 2), knight_am(6, 3), knight_am(6, 4), knight_am(6, 5), knight_am(6, 6), knight_am(6, 7),
-        knight_am(7, 0), knight_am(7, 1), knight_am(7, 2), knight_am(7, 3), knight_am(7, 4), knight_am(7, 5), knight_am(7, 6), knight_am(7, 7)
-    };
-
-    board_t attacking_mask_rook_left[64] = {
-        rook_left_am(0, 0), rook_left_am(0, 1), rook_left_am(0, 2), rook_left_am(0, 3), rook_left_am(0, 4), rook_left_am(0, 5), rook_left_am(0, 6), rook_left_am(0, 7),
-        rook_left_am(1, 0), rook_left_am(1, 1), rook_left_am(1, 2), rook_left_am(1, 3), rook_left_am(1, 4), rook_left_am(1, 5), rook_left_am(1, 6), rook_left_am(1, 7),
-        rook_left_am(2, 0), rook_left_am(2, 1), rook_left_am(2, 2), rook_left_am(2, 3), rook_left_am(2, 4), rook_left_am(2, 5), rook_left_am(2, 6), rook_left_am(2, 7),
-        rook_left_am(3, 0), rook_left_am(3, 1), rook_left_am(3, 2), rook_left_am(3, 3), rook_left_am(3, 4), rook_left_am(3, 5), rook_left_am(3, 6), rook_left_am(3, 7),
-        rook_left_am(4, 0), rook_left_am(4, 1), rook_left_am(4, 2), rook_left_am(4, 3), rook_left_am(4, 4), rook_left_am(4, 5), rook_left_am(4, 6), rook_left_am(4, 7),
-        rook_left_am(5, 0), rook_left_am(5, 1), rook_left_am(5, 2), rook_left_am(5, 3), rook_left_am(5, 4), rook_left_am(5, 5), rook_left_am(5, 6), rook_left_am(5, 7),
-        rook_left_am(6, 0), rook_left_am(6, 1), rook_left_am(6, 2), rook_left_am(6, 3), rook_left_am(6, 4), rook_left_am(6, 5), rook_left_am(6, 6), rook_left_am(6, 7),
-        rook_left_am(7, 0), rook_left_am(7, 1), rook_left_am(7, 2), rook_left_am(7, 3), rook_left_am(7, 4), rook_left_am(7, 5), rook_left_am(7, 6), rook_left_am(7, 7)
-    };
-
-    board_t attacking_mask_rook_right[64] = {
-        rook_right_am(0, 0), rook_right_am(0, 1), rook_right_am(0, 2), rook_right_am(0, 3), rook_right_am(0, 4), rook_right_am(0, 5), rook_right_am(0, 6), rook_right_am(0, 7),
-        rook_right_am(1, 0), rook_right_am(1, 1), rook_right_am(1, 2), rook_right_am(1, 3), rook_right_am(1, 4), rook_right_am(1, 5), rook_right_am(1, 6), rook_right_am(1, 7),
-        rook_right_am(2, 0), rook_right_am(2, 1), rook_right_am(2, 2), rook_right_am(2, 3), rook_right_am(2, 4), rook_right_am(2, 5), rook_right_am(2, 6), rook_right_am(2, 7),
-        rook_right_am(3, 0), rook_right_am(3, 1), rook_right_am(3, 2), rook_right_am(3, 3), rook_right_am(3, 4), rook_right_am(3, 5), rook_right_am(3, 6), rook_right_am(3, 7),
-        rook_right_am(4, 0), rook_right_am(4, 1), rook_right_am(4, 2), rook_right_am(4, 3), rook_right_am(4, 4), rook_right_am(4, 5), rook_right_am(4, 6), rook_right_am(4, 7),
-        rook_right_am(5, 0), rook_right_am(5, 1), rook_right_am(5, 2), rook_right_am(5, 3), rook_right_am(5, 4), rook_right_am(5, 5), rook_right_am(5, 6), rook_right_am(5, 7),
-        rook_right_am(6, 0), rook_right_am(6, 1), rook_right_am(6, 2), rook_right_am(6, 3), rook_right_am(6, 4), rook_right_am(6, 5), rook_right_am(6, 6), rook_right_am(6, 7),
-        rook_right_am(7, 0), rook_right_am(7, 1), rook_right_am(7, 2), rook_right_am(7, 3), rook_right_am(7, 4), rook_right_am(7, 5), rook_right_am(7, 6), rook_right_am(7, 7)
-    };
-
-    board_t attacking_mask_rook_up[64] = {
-        rook_up_am(0, 0), rook_up_am(0, 1), rook_up_am(0, 2), rook_up_am(0, 3), rook_up_am(0, 4), rook_up_am(0, 5), rook_up_am(0, 6), rook_up_am(0, 7),
-        rook_up_am(1, 0), rook_up_am(1, 1), rook_up_am(1, 2), rook_up_am(1, 3), rook_up_am(1, 4), rook_up_am(1, 5), rook_up_am(1, 6), rook_up_am(1, 7),
-        rook_up_am(2, 0), rook_up_am(2, 1), rook_up_am(2, 2), rook_up_am(2, 3), rook_up_am(2, 4), rook_up_am(2, 5), rook_up_am(2, 6), rook_up_am(2, 7),
-        rook_up_am(3, 0), rook_up_am(3, 1), rook_up_am(3, 2), rook_up_am(3, 3), rook_up_am(3, 4), rook_up_am(3, 5), rook_up_am(3, 6), rook_up_am(3, 7),
-        rook_up_am(4, 0), rook_up_am(4, 1), rook_up_am(4, 2), rook_up_am(4, 3), rook_up_am(4, 4), rook_up_am(4, 5), rook_up_am(4, 6), rook_up_am(4, 7),
-        rook_up_am(5, 0), rook_up_am(5, 1), rook_up_am(5, 2), rook_up_am(5, 3), rook_up_am(5, 4), rook_up_am(5, 5), rook_up_am(5, 6), rook_up_am(5, 7),
-        rook_up_am(6, 0), rook_up_am(6, 1), rook_up_am(6, 2), rook_up_am(6, 3), rook_up_am(6, 4), rook_up_am(6, 5), rook_up_am(6, 6), rook_up_am(6, 7),
-        rook_up_am(7, 0), rook_up_am(7, 1), rook_up_am(7, 2), rook_up_am(7, 3), rook_up_am(7, 4), rook_up_am(7, 5), rook_up_am(7, 6), rook_up_am(7, 7)
-    };
-
-    board_t attacking_mask_rook_down[64] = {
-        rook_down_am(0, 0), rook_down_am(0, 1), rook_down_am(0, 2), rook_down_am(0, 3), rook_down_am(0, 4), rook_down_am(0, 5), rook_down_am(0, 6), rook_down_am(0, 7),
-        rook_down_am(1, 0), rook_down_am(1, 1), rook_down_am(1, 2), rook_down_am(1, 3), rook_down_am(1, 4), rook_down_am(1, 5), rook_down_am(1, 6), rook_down_am(1, 7),
-        rook_down_am(2, 0), rook_down_am(2, 1), rook_down_am(2, 2), rook_down_am(2, 3), rook_down_am(2, 4), rook_down_am(2, 5), rook_down_am(2, 6), rook_down_am(2, 7),
-        rook_down_am(3, 0), rook_down_am(3, 1), rook_down_am(3, 2), rook_down_am(3, 3), rook_down_am(3, 4), rook_down_am(3, 5), rook_down_am(3, 6), rook_down_am(3, 7),
-        rook_down_am(4, 0), rook_down_am(4, 1), rook_down_am(4, 2), rook_down_am(4, 3), rook_down_am(4, 4), rook_down_am(4, 5), rook_down_am(4, 6), rook_down_am(4, 7),
-        rook_down_am(5, 0), rook_down_am(5, 1), rook_down_am(5, 2), rook_down_am(5, 3), rook_down_am(5, 4), rook_down_am(5, 5), rook_down_am(5, 6), rook_down_am(5, 7),
-        rook_down_am(6, 0), rook_down_am(6, 1), rook_down_am(6, 2), rook_down_am(6, 3), rook_down_am(6, 4), rook_down_am(6, 5), rook_down_am(6, 6), rook_down_am(6, 7),
-        rook_down_am(7, 0), rook_down_am(7, 1), rook_down_am(7, 2), rook_down_am(7, 3), rook_down_am(7, 4), rook_down_am(7, 5), rook_down_am(7, 6), rook_down_am(7, 7)
-    };
-
-    board_t attacking_mask_bishop_right_up[64] = {
-        bishop_right_up_am(0, 0), bishop_right_up_am(0, 1), bishop_right_up_am(0, 2), bishop_right_up_am(0, 3), bishop_right_up_am(0, 4), bishop_right_up_am(0, 5), bishop_right_up_am(0, 6), bishop_right_up_am(0, 7),
-        bishop_right_up_am(1, 0), bishop_right_up_am(1, 1), bishop_right_up_am(1, 2), bishop_right_up_am(1, 3), bishop_right_up_am(1, 4), bishop_right_up_am(1, 5), bishop_right_up_am(1, 6), bishop_right_up_am(1, 7),
-        bishop_right_up_am(2, 0), bishop_right_up_am(2, 1), bishop_right_up_am(2, 2), bishop_right_up_am(2, 3), bishop_right_up_am(2, 4), bishop_right_up_am(2, 5), bishop_right_up_am(2, 6), bishop_right_up_am(2, 7),
-        bishop_right_up_am(3, 0), bishop_right_up_am(3, 1), bishop_right_up_am(3, 2), bishop_right_up_am(3, 3), bishop_right_up_am(3, 4), bishop_right_up_am(3, 5), bishop_right_up_am(3, 6), bishop_right_up_am(3, 7),
-        bishop_right_up_am(4, 0), bishop_right_up_am(4, 1), bishop_right_up_am(4, 2), bishop_right_up_am(4, 3), bishop_right_up_am(4, 4), bishop_right_up_am(4, 5), bishop_right_up_am(4, 6), bishop_right_up_am(4, 7),
-        bishop_right_up_am(5, 0), bishop_right_up_am(5, 1), bishop_right_up_am(5, 2), bishop_right_up_am(5, 3), bishop_right_up_am(5, 4), bishop_right_up_am(5, 5), bishop_right_up_am(5, 6), bishop_right_up_am(5, 7),
-        bishop_right_up_am(6, 0), bishop_right_up_am(6, 1), bishop_right_up_am(6, 2), bishop_right_up_am(6, 3), bishop_right_up_am(6, 4), bishop_right_up_am(6, 5), bishop_right_up_am(6, 6), bishop_right_up_am(6, 7),
-        bishop_right_up_am(7, 0), bishop_right_up_am(7, 1), bishop_right_up_am(7, 2), bishop_right_up_am(7, 3), bishop_right_up_am(7, 4), bishop_right_up_am(7, 5), bishop_right_up_am(7, 6), bishop_right_up_am(7, 7)
-    };
-
-    board_t attacking_mask_bishop_right_down[64] = {
-        bishop_right_down_am(0, 0), bishop_right_down_am(0, 1), bishop_right_down_am(0, 2), bishop_right_down_am(0, 3), bishop_right_down_am(0, 4), bishop_right_down_am(0, 5), bishop_right_down_am(0, 6), bishop_right_down_am(0, 7),
-        bishop_right_down_am(1, 0), bishop_right_down_am(1, 1), bishop_right_down_am(1, 2), bishop_right_down_am(1, 3), bishop_right_down_am(1, 4), bishop_right_down_am(1, 5), bishop_right_down_am(1, 6), bishop_right_down_am(1, 7),
-        bishop_right_down_am(2, 0), bishop_right_down_am(2, 1), bishop_right_down_am(2, 2), bishop_right_down_am(2, 3), bishop_right_down_am(2, 4), bishop_right_down_am(2, 5), bishop_right_down_am(2, 6), bishop_right_down_am(2, 7),
-        bishop_right_down_am(3, 0), bishop_right_down_am(3, 1), bishop_right_down_am(3, 2), bishop_right_down_am(3, 3), bishop_right_down_am(3, 4), bishop_right_down_am(3, 5), bishop_right_down_am(3, 6), bishop_right_down_am(3, 7),
-        bishop_right_down_am(4, 0), bishop_right_down_am(4, 1), bishop_right_down_am(4, 2), bishop_right_down_am(4, 3), bishop_right_down_am(4, 4), bishop_right_down_am(4, 5), bishop_right_down_am(4, 6), bishop_right_down_am(4, 7),
-        bishop_right_down_am(5, 0), bishop_right_down_am(5, 1), bishop_right_down_am(5, 2), bishop_right_down_am(5, 3), bishop_right_down_am(5, 4), bishop_right_down_am(5, 5), bishop_right_down_am(5, 6), bishop_right_down_am(5, 7),
-        bishop_right_down_am(6, 0), bishop_right_down_am(6, 1), bishop_right_down_am(6, 2), bishop_right_down_am(6, 3), bishop_right_down_am(6, 4), bishop_right_down_am(6, 5), bishop_right_down_am(6, 6), bishop_right_down_am(6, 7),
-        bishop_right_down_am(7, 0), bishop_right_down_am(7, 1), bishop_right_down_am(7, 2), bishop_right_down_am(7, 3), bishop_right_down_am(7, 4), bishop_right_down_am(7, 5), bishop_right_down_am(7, 6), bishop_right_down_am(7, 7)
-    };
-
-    board_t attacking_mask_bishop_left_down[64] = {
-        bishop_left_down_am(0, 0), bishop_left_down_am(0, 1), bishop_left_down_am(0, 2), bishop_left_down_am(0, 3), bishop_left_down_am(0, 4), bishop_left_down_am(0, 5), bishop_left_down_am(0, 6), bishop_left_down_am(0, 7),
-        bishop_left_down_am(1, 0), bishop_left_down_am(1, 1), bishop_left_down_am(1, 2), bishop_left_down_am(1, 3), bishop_left_down_am(1, 4), bishop_left_down_am(1, 5), bishop_left_down_am(1, 6), bishop_left_down_am(1, 7),
-        bishop_left_down_am(2, 0), bishop_left_down_am(2, 1), bishop_left_down_am(2, 2), bishop_left_down_am(2, 3), bishop_left_down_am(2, 4), bishop_left_down_am(2, 5), bishop_left_down_am(2, 6), bishop_left_down_am(2, 7),
-        bishop_left_down_am(3, 0), bishop_left_down_am(3, 1), bishop_left_down_am(3, 2), bishop_left_down_am(3, 3), bishop_left_down_am(3, 4), bishop_left_down_am(3, 5), bishop_left_down_am(3, 6), bishop_left_down_am(3, 7),
-        bishop_left_down_am(4, 0), bishop_left_down_am(4, 1), bishop_left_down_am(4, 2), bishop_left_down_am(4, 3), bishop_left_down_am(4, 4), bishop_left_down_am(4, 5), bishop_left_down_am(4, 6), bishop_left_down_am(4, 7),
-        bishop_left_down_am(5, 0), bishop_left_down_am(5, 1), bishop_left_down_am(5, 2), bishop_left_down_am(5, 3), bishop_left_down_am(5, 4), bishop_left_down_am(5, 5), bishop_left_down_am(5, 6), bishop_left_down_am(5, 7),
-        bishop_left_down_am(6, 0), bishop_left_down_am(6, 1), bishop_left_down_am(6, 2), bishop_left_down_am(6, 3), bishop_left_down_am(6, 4), bishop_left_down_am(6, 5), bishop_left_down_am(6, 6), bishop_left_down_am(6, 7),
-        bishop_left_down_am(7, 0), bishop_left_down_am(7, 1), bishop_left_down_am(7, 2), bishop_left_down_am(7, 3), bishop_left_down_am(7, 4), bishop_left_down_am(7, 5), bishop_left_down_am(7, 6), bishop_left_down_am(7, 7)
-    };
-
-    board_t attacking_mask_bishop_left_up[64] = {
-        bishop_left_up_am(0, 0), bishop_left_up_am(0, 1), bishop_left_up_am(0, 2), bishop_left_up_am(0, 3), bishop_left_up_am(0, 4), bishop_left_up_am(0, 5), bishop_left_up_am(0, 6), bishop_left_up_am(0, 7),
-        bishop_left_up_am(1, 0), bishop_left_up_am(1, 1), bishop_left_up_am(1, 2), bishop_left_up_am(1, 3), bishop_left_up_am(1, 4), bishop_left_up_am(1, 5), bishop_left_up_am(1, 6), bishop_left_up_am(1, 7),
-        bishop_left_up_am(2, 0), bishop_left_up_am(2, 1), bishop_left_up_am(2, 2), bishop_left_up_am(2, 3), bishop_left_up_am(2, 4), bishop_left_up_am(2, 5), bishop_left_up_am(2, 6), bishop_left_up_am(2, 7),
-        bishop_left_up_am(3, 0), bishop_left_up_am(3, 1), bishop_left_up_am(3, 2), bishop_left_up_am(3, 3), bishop_left_up_am(3, 4), bishop_left_up_am(3, 5), bishop_left_up_am(3, 6), bishop_left_up_am(3, 7),
-        bishop_left_up_am(4, 0), bishop_left_up_am(4, 1), bishop_left_up_am(4, 2), bishop_left_up_am(4, 3), bishop_left_up_am(4, 4), bishop_left_up_am(4, 5), bishop_left_up_am(4, 6), bishop_left_up_am(4, 7),
-        bishop_left_up_am(5, 0), bishop_left_up_am(5, 1), bishop_left_up_am(5, 2), bishop_left_up_am(5, 3), bishop_left_up_am(5, 4), bishop_left_up_am(5, 5), bishop_left_up_am(5, 6), bishop_left_up_am(5, 7),
-        bishop_left_up_am(6, 0), bishop_left_up_am(6, 1), bishop_left_up_am(6, 2), bishop_left_up_am(6, 3), bishop_left_up_am(6, 4), bishop_left_up_am(6, 5), bishop_left_up_am(6, 6), bishop_left_up_am(6, 7),
-        bishop_left_up_am(7, 0), bishop_left_up_am(7, 1), bishop_left_up_am(7, 2), bishop_left_up_am(7, 3), bishop_left_up_am(7, 4), bishop_left_up_am(7, 5), bishop_left_up_am(7, 6), bishop_left_up_am(7, 7)
-    };
-
-    board_t attacking_mask_rook[64] = {
-        rook_am(0, 0), rook_am(0, 1), rook_am(0, 2), rook_am(0, 3), rook_am(0, 4), rook_am(0, 5), rook_am(0, 6), rook_am(0, 7),
-        rook_am(1, 0), rook_am(1, 1), rook_am(1, 2), rook_am(1, 3), rook_am(1, 4), rook_am(1, 5), rook_am(1, 6), rook_am(1, 7),
-        rook_am(2, 0), rook_am(2, 1), rook_am(2, 2), rook_am(2, 3), rook_am(2, 4), rook_am(2, 5), rook_am(2, 6), rook_am(2, 7),
-        rook_am(3, 0), rook_am(3, 1), rook_am(3, 2), rook_am(3, 3), rook_am(3, 4), rook_am(3, 5), rook_am(3, 6), rook_am(3, 7),
-        rook_am(4, 0), rook_am(4, 1), rook_am(4, 2), rook_am(4, 3), rook_am(4, 4), rook_am(4, 5), rook_am(4, 6), rook_am(4, 7),
-        rook_am(5, 0), rook_am(5, 1), rook_am(5, 2), rook_am(5, 3), rook_am(5, 4), rook_am(5, 5), rook_am(5, 6), rook_am(5, 7),
-        rook_am(6, 0), rook_am(6, 1), rook_am(6, 2), rook_am(6, 3), rook_am(6, 4), rook_am(6, 5), rook_am(6, 6), rook_am(6, 7),
-        rook_am(7, 0), rook_am(7, 1), rook_am(7, 2), rook_am(7, 3), rook_am(7, 4), rook_am(7, 5), rook_am(7, 6), rook_am(7, 7)
-    };
-
-    board_t attacking_mask_bishop[64] = {
-        bishop_am(0, 0), bishop_am(0, 1), bishop_am(0, 2), bishop_am(0, 3), bishop_am(0, 4), bishop_am(0, 5), bishop_am(0, 6), bishop_am(0, 7),
-        bishop_am(1, 0), bishop_am(1, 1), bishop_am(1, 2), bishop_am(1, 3), bishop_am(1, 4), bishop_am(1, 5), bishop_am(1, 6), bishop_am(1, 7),
-        bishop_am(2, 0), bishop_am(2, 1), bishop_am(2, 2), bishop_am(2, 3), bishop_am(2, 4), bishop_am(2, 5), bishop_am(2, 6), bishop_am(2, 7),
-        bishop_am(3, 0), bishop_am(3, 1), bishop_am(3, 2), bishop_am(3, 3), bishop_am(3, 4), bishop_am(3, 5), bishop_am(3, 6), bishop_am(3, 7),
-        bishop_am(4, 0), bishop_am(4, 1), bishop_am(4, 2), bishop_am(4, 3), bishop_am(4, 4), bishop_am(4, 5), bishop_am(4, 6), bishop_am(4, 7),
-        bishop_am(5, 0), bishop_am(5, 1), bishop_am(5, 2), bishop_am(5, 3), bishop_am(5, 4), bishop_am(5, 5), bishop_am(5, 6), bishop_am(5, 7),
-        bishop_am(6, 0), bishop_am(6, 1), bishop_am(6, 2), bishop_am(6, 3), bishop_am(6, 4), bishop_am(6, 5), bishop_am(6, 6), bishop_am(6, 7),
-        bishop_am(7, 0), bishop_am(7, 1), bishop_am(7, 2), bishop_am(7, 3), bishop_am(7, 4), bishop_am(7, 5), bishop_am(7, 6), bishop_am(7, 7)
-    };
-
-    board_t attacking_mask_queen[64] = {
-        queen_am(0, 0), queen_am(0, 1), queen_am(0, 2), queen_am(0, 3), queen_am(0, 4), queen_am(0, 5), queen_am(0, 6), queen_am(0, 7),
-        queen_am(1, 0), queen_am(1, 1), queen_am(1, 2), queen_am(1, 3), queen_am(1, 4), queen_am(1, 5), queen_am(1, 6), queen_am(1, 7),
-        queen_am(2, 0), queen_am(2, 1), queen_am(2, 2), queen_am(2, 3), queen_am(2, 4), queen_am(2, 5), queen_am(2, 6), queen_am(2, 7),
-        queen_am(3, 0), queen_am(3, 1), queen_am(3, 2), queen_am(3, 3), queen_am(3, 4), queen_am(3, 5), queen_am(3, 6), queen_am(3, 7),
-        queen_am(4, 0), queen_am(4, 1), queen_am(4, 2), queen_am(4, 3), queen_am(4, 4), queen_am(4, 5), queen_am(4, 6), queen_am(4, 7),
-        queen_am(5, 0), queen_am(5, 1), queen_am(5, 2), queen_am(5, 3), queen_am(5, 4), queen_am(5, 5), queen_am(5, 6), queen_am(5, 7),
-        queen_am(6, 0), queen_am(6, 1), queen_am(6, 2), queen_am(6, 3), queen_am(6, 4), queen_am(6, 5), queen_am(6, 6), queen_am(6, 7),
-        queen_am(7, 0), queen_am(7, 1), queen_am(7, 2), queen_am(7, 3), queen_am(7, 4), queen_am(7, 5), queen_am(7, 6), queen_am(7, 7)
-    };
-
-    constexpr board_t king_am(int row, int col)
-    {
-        board_t mask = 0;
-        if (row > 0)
-            mask |= square_mask(row - 1, col);
-        if (row < 7)
-            mask |= square_mask(row + 1, col);
-        if (col > 0)
-            mask |= square_mask(row, col - 1);
-        if (col < 7)
-            mask |= square_mask(row, col + 1);
-        if (row > 0 && col > 0)
-            mask |= square_mask(row - 1, col - 1);
-        if (row > 0 && col < 7)
-            mask |= square_mask(row - 1, col + 1);
-        if (row < 7 && col > 0)
-            mask |= square_mask(row + 1, col - 1);
-        if (row < 7 && col < 7)
-            mask |= square_mask(row + 1, col + 1);
-
-        return mask;
-    }
-
-    constexpr board_t knight_am(int row, int col)
-    {
-        board_t mask = 0;
-        if (row - 2 >= 0 && col - 1 >= 0)
-            mask |= square_mask(row - 2, col - 1);
-        if (row - 2 >= 0 && col + 1 <= 7)
-            mask |= square_mask(row - 2, col + 1);
-        if (row - 1 >= 0 && col - 2 >= 0)
-            mask |= square_mask(row - 1, col - 2);
-        if (row - 1 >= 0 && col + 2 <= 7)
-            mask |= square_mask(row - 1, col + 2);
-        if (row + 1 <= 7 && col - 2 >= 0)
-            mask |= square_mask(row + 1, col - 2);
-        if (row + 1 <= 7 && col + 2 <= 7)
-            mask |= square_mask(row + 1, col + 2);
-        if (row + 2 <= 7 && col - 1 >= 0)
-            mask |= square_mask(row + 2, col - 1);
-        if (row + 2 <= 7 && col + 1 <= 7)
-            mask |= square_mask(row + 2, col + 1);
-
-        return mask;
-    }
-
-    constexpr board_t rook_left_am(int row, int col)
-    {
-        board_t mask = 0;
-
-        for (int i = 0; i < col; ++i)
-            bit_set(mask, row, i);
-
-        return mask;
-    }
-
-    constexpr board_t rook_right_am(int row, int col)
-    {
-        board_t mask = 0;
-
-        for (int i = col + 1; i < 8; ++i)
-            bit_set(mask, row, i);
-
-        return mask;
-    }
-
-    constexpr board_t rook_up_am(int row, int col)
-    {
-        board_t mask = 0;
-
-        for (int i = row + 1; i < 8; ++i)
-            bit_set(mask, i, col);
-
-        return mask;
-    }
-
-    constexpr board_t rook_down_am(int row, int col)
-    {
-        board_t mask = 0;
-
-        for (int i = 0; i < row; ++i)
-            bit_set(mask, i, col);
-
-        return mask;
-    }
-
-    constexpr board_t bishop_right_up_am(int row, int col)
-    {
-        board_t mask = 0;
-
-        for (++row, ++col; row < 8 && col < 8; ++row, ++col)
-            bit_set(mask, row, col);
-
-        return mask;
-    }
-
-    constexpr board_t bishop_right_down_am(int row, int col)
-    {
-        board_t mask = 0;
-
-        for (--row, ++col; row >= 0 && col < 8; --row, ++col)
-            bit_set(mask, row, col);
-
-        return mask;
-    }
-
-    constexpr board_t bishop_left_down_am(int row, int col)
-    {
-        board_t mask = 0;
-
-        for (--row, --col; row >= 0 && col >= 0; --row, --col)
-            bit_set(mask, row, col);
-
-        return mask;
-    }
-
-    constexpr board_t bishop_left_up_am(int row, int col)
-    {
-        board_t mask = 0;
-
-        for (++row, --col; row < 8 && col >= 0; ++row, --col)
-            bit_set(mask, row, col);
-
-        return mask;
-    }
-
-    constexpr board_t rook_am(int row, int col)
-    {
-        return rook_left_am(row, col) | rook_right_am(row, col) | rook_up_am(row, col) | rook_down_am(row, col);
-    }
-
-    constexpr board_t bishop_am(int row, int col)
-    {
-        return bishop_right_up_am(row, col) | bishop_right_down_am(row, col) | bishop_left_down_am(row, col) | bishop_left_up_am(row, col);
-    }
-
-    constexpr board_t queen_am(int row, int col)
-    {
-        return rook_am(row, col) | bishop_am(row, col);
-    }
-
-    // sets pos_from bit to false and pot_to bit to true on bitboard b
-    constexpr board_t move_piece_in_bit_mask(board_t b, square_t pos_from, square_t pos_to)
-    {
-        b &= ~(1ull << pos_from);
-        b |= 1ull << pos_to;
-
-        return b;
-    }
-
-    constexpr bool is_rook_left_attacked(board_t attacker_mask, board_t mask_blockers, square_t test_pos)
-    {
-        board_t mask = attacking_mask_rook_left[test_pos];
-
-        mask &= attacker_mask;
-
-        if (!mask)
-            return false;
-
-        mask_blockers &= attacking_mask_rook_left[test_pos];
-
-        return bit_pos_msb(mask_blockers) < bit_pos_msb(mask);
-    }
-
-    constexpr bool is_rook_left_valid(int pos_from_col, square_t pos_from, square_t pos_to)
-    {
-        board_t mask = attacking_mask_rook_left[king_pos];
-        board_t attacker_mask = (white_to_move ? black : white) & (rooks | queens);
-        bit_reset(attacker_mask, pos_to);
-
-        mask &= attacker_mask;
-
-        if (!mask)
-            return true;
-
-        board_t mask_blockers = (black | white) & ~attacker_mask;
-        mask_blockers = move_piece_in_bit_mask(mask_blockers, pos_from, pos_to);
-        mask_blockers &= attacking_mask_rook_left[king_pos];
-
-        return bit_pos_msb(mask_blockers) > bit_pos_msb(mask);
-    }
-
-    constexpr bool is_rook_right_attacked(board_t attacker_mask, board_t mask_blockers, square_t test_pos)
-    {
-        board_t mask = attacking_mask_rook_right[test_pos];
-
-        mask &= attacker_mask;
-
-        if (!mask)
-            return false;
-
-        mask_blockers &= attacking_mask_rook_right[test_pos];
-
-        return bit_pos_lsb(mask_blockers) > bit_pos_lsb(mask);
-    }
-
-    constexpr bool is_rook_right_valid(int pos_from_col, square_t pos_from, square_t pos_to)
-    {
-        board_t mask = attacking_mask_rook_right[king_pos];
-        board_t attacker_mask = (white_to_move ? black : white) & (rooks | queens);
-        bit_reset(attacker_mask, pos_to);
-
-        mask &= attacker_mask;
-
-        if (!mask)
-            return true;
-
-        board_t mask_blockers = (black | white) & ~attacker_mask;
-        mask_blockers = move_piece_in_bit_mask(mask_blockers, pos_from, pos_to);
-        mask_blockers &= attacking_mask_rook_right[king_pos];
-
-        return bit_pos_lsb(mask_blockers) < bit_pos_lsb(mask);
-    }
-
-    constexpr bool is_rook_up_attacked(board_t attacker_mask, board_t mask_blockers, square_t test_pos)
-    {
-        board_t mask = attacking_mask_rook_up[test_pos];
-
-        mask &= attacker_mask;
-
-        if (!mask)
-            return false;
-
-        mask_blockers &= attacking_mask_rook_up[test_pos];
-
-        return bit_pos_lsb(mask_blockers) > bit_pos_lsb(mask);
-    }
-
-    constexpr bool is_rook_up_valid(int pos_from_row, square_t pos_from, square_t pos_to)
-    {
-        board_t mask = attacking_mask_rook_up[king_pos];
-        board_t attacker_mask = (white_to_move ? black : white) & (rooks | queens);
-        bit_reset(attacker_mask, pos_to);
-
-        mask &= attacker_mask;
-
-        if (!mask)
-            return true;
-
-        board_t mask_blockers = (black | white) & ~attacker_mask;
-        mask_blockers = move_piece_in_bit_mask(mask_blockers, pos_from, pos_to);
-        mask_blockers &= attacking_mask_rook_up[king_pos];
-
-        return bit_pos_lsb(mask_blockers) < bit_pos_lsb(mask);
-    }
-
-    constexpr bool is_rook_down_attacked(board_t attacker_mask, board_t mask_blockers, square_t test_pos)
-    {
-        board_t mask = attacking_mask_rook_down[test_pos];
-
-        mask &= attacker_mask;
-
-        if (!mask)
-            return false;
-
-        mask_blockers &= attacking_mask_rook_down[test_pos];
-
-        return bit_pos_msb(mask_blockers) < bit_pos_msb(mask);
-    }
-
-    constexpr bool is_rook_down_valid(int pos_from_row, int pos_from, int pos_to)
-    {
-        board_t mask = attacking_mask_rook_down[king_pos];
-        board_t attacker_mask = (white_to_move ? black : white) & (rooks | queens);
-        bit_reset(attacker_mask, pos_to);
-
-        mask &= attacker_mask;
-
-        if (!mask)
-            return true;
-
-        board_t mask_blockers = (black | white) & ~attacker_mask;
-        mask_blockers = move_piece_in_bit_mask(mask_blockers, pos_from, pos_to);
-        mask_blockers &= attacking_mask_rook_down[king_pos];
-
-        return bit_pos_msb(mask_blockers) > bit_pos_msb(mask);
-    }
-
-    constexpr bool is_bishop_right_down_attacked(board_t attacker_mask, board_t mask_blockers, int test_pos)
-    {
-        board_t mask = attacking_mask_bishop_right_down[test_pos];
-
-        mask &= attacker_mask;
-
-        if (!mask)
-            return false;
-
-        mask_blockers &= attacking_mask_bishop_right_down[test_pos];
-
-        return bit_pos_msb(mask_blockers) < bit_pos_msb(mask);
-    }
-
-    constexpr bool is_bishop_right_down_valid(int pos_from_col, int pos_from, int pos_to)
-    {
-        board_t mask = attacking_mask_bishop_right_down[king_pos];
-        board_t attacker_mask = (white_to_move ? black : white) & (bishops | queens);
-        bit_reset(attacker_mask, pos_to);
-
-        mask &= attacker_mask;
-
-        if (!mask)
-            return true;
-
-        board_t mask_blockers = (black | white) & ~attacker_mask;
-        mask_blockers = move_piece_in_bit_mask(mask_blockers, pos_from, pos_to);
-        mask_blockers &= attacking_mask_bishop_right_down[king_pos];
-
-        return bit_pos_msb(mask_blockers) > bit_pos_msb(mask);
-    }
-
-    constexpr bool is_bishop_right_up_attacked(board_t attacker_mask, board_t mask_blockers, int test_pos)
-    {
-        board_t mask = attacking_mask_bishop_right_up[test_pos];
-
-        mask &= attacker_mask;
-
-        if (!mask)
-            return false;
-
-        mask_blockers &= attacking_mask_bishop_right_up[test_pos];
-
-        return bit_pos_lsb(mask_blockers) > bit_pos_lsb(mask);
-    }
-
-    constexpr bool is_bishop_right_up_valid(int pos_from_col, int pos_from, int pos_to)
-    {
-        board_t mask = attacking_mask_bishop_right_up[king_pos];
-        board_t attacker_mask = (white_to_move ? black : white) & (bishops | queens);
-        bit_reset(attacker_mask, pos_to);
-
-        mask &= attacker_mask;
-
-        if (!mask)
-            return true;
-
-        board_t mask_blockers = (black | white) & ~attacker_mask;
-        mask_blockers = move_piece_in_bit_mask(mask_blockers, pos_from, pos_to);
-        mask_blockers &= attacking_mask_bishop_right_up[king_pos];
-
-        return bit_pos_lsb(mask_blockers) < bit_pos_lsb(mask);
-    }
-
-    constexpr bool is_bishop_left_down_attacked(board_t attacker_mask, board_t mask_blockers, int test_pos)
-    {
-        board_t mask = attacking_mask_bishop_left_down[test_pos];
-
-        mask &= attacker_mask;
-
-        if (!mask)
-            return false;
-
-        mask_blockers &= attacking_mask_bishop_left_down[test_pos];
-
-        return bit_pos_msb(mask_blockers) < bit_pos_msb(mask);
-    }
 
-    constexpr bool is_bishop_left_down_valid(int pos_from_col, int pos_from, int pos_to)
+    // squares a piece standing on pos may move to without leaving the king in check
+    // a pinned piece is restricted to the line through the king and the pinning piece
+    board_t legal_mask(square_t pos)
     {
-        board_t mask = attacking_mask_bishop_left_down[king_pos];
-        board_t attacker_mask = (white_to_move ? black : white) & (bishops | queens);
-        bit_reset(attacker_mask, pos_to);
-
-        mask &= attacker_mask;
-
-        if (!mask)
-            return true;
-
-        board_t mask_blockers = (black | white) & ~attacker_mask;
-        mask_blockers = move_piece_in_bit_mask(mask_blockers, pos_from, pos_to);
-        mask_blockers &= attacking_mask_bishop_left_down[king_pos];
+        if (pinned & (1ull << pos))
+            return check_mask & line_masks[king_pos][pos];
 
-        return bit_pos_msb(mask_blockers) > bit_pos_msb(mask);
+        return check_mask;
     }
 
-    constexpr bool is_bishop_left_up_attacked(board_t attacker_mask, board_t mask_blockers, int test_pos)
+    // adds a move to every square set in targets
+    void add_moves(MoveList& valid_moves, piece_no_color_t moving_piece, square_t pos_from, board_t targets)
     {
-        board_t mask = attacking_mask_bishop_left_up[test_pos];
-
-        mask &= attacker_mask;
-
-        if (!mask)
-            return false;
-
-        mask_blockers &= attacking_mask_bishop_left_up[test_pos];
-
-        return bit_pos_lsb(mask_blockers) > bit_pos_lsb(mask);
-    }
-
-    constexpr bool is_bishop_left_up_valid(int pos_from_col, int pos_from, int pos_to)
-    {
-        board_t mask = attacking_mask_bishop_left_up[king_pos];
-        board_t attacker_mask = (white_to_move ? black : white) & (bishops | queens);
-        bit_reset(attacker_mask, pos_to);
-
-        mask &= attacker_mask;
-
-        if (!mask)
-            return true;
-
-        board_t mask_blockers = (black | white) & ~attacker_mask;
-        mask_blockers = move_piece_in_bit_mask(mask_blockers, pos_from, pos_to);
-        mask_blockers &= attacking_mask_bishop_left_up[king_pos];
-
-        return bit_pos_lsb(mask_blockers) < bit_pos_lsb(mask);
-    }
-
-    // allows to rule out the possibility that a move reveals an attack on the king fast
-    // true - for sure it is valid
-    // false - do not know
-    constexpr bool is_move_valid_fast_unsure(square_t pos_from, square_t pos_to)
-    {
-        if (all_safe)
-            return true;
-
-        if (king_in_check)
-            return false;
-
-        if (!(b_need_inspection & (1ull << pos_from)))
-            return true;
-
-        board_t takeover_mask = ~(1ull << pos_to);
-        if (!(attacking_mask_rook[pos_from] & (opp_color_mask & (queens | rooks) & takeover_mask)) && !(attacking_mask_bishop[pos_from] & (opp_color_mask & (queens | bishops) & takeover_mask)))
-            return true;
-
-        return false;
+        for (; targets; targets &= targets - 1)
+            valid_moves.push_back(encode_move(moving_piece, pos_from, bit_pos(targets)));
     }
 
-    // checks if a move reveals an attack on the king
-    constexpr bool is_move_valid(square_t pos_from, square_t pos_to)
+    // adds all four promotions of a pawn move
+    void add_promotions(MoveList& valid_moves, square_t pos_from, square_t pos_to)
     {
-        int pos_from_row = get_row(pos_from);
-        int pos_from_col = get_col(pos_from);
-
-        if (pos_from_row == king_pos_row)
-        {
-            if (pos_from_col < king_pos_col)
-                return is_rook_left_valid(pos_from_col, pos_from, pos_to);
-            else
-                return is_rook_right_valid(pos_from_col, pos_from, pos_to);
-        }
-
-        if (pos_from_col == king_pos_col)
-        {
-            if (pos_from_row < king_pos_row)
-                return is_rook_down_valid(pos_from_row, pos_from, pos_to);
-            else
-                return is_rook_up_valid(pos_from_row, pos_from, pos_to);
-        }
-
-        int dif_row = pos_from_row - king_pos_row;
-        int dif_col = pos_from_col - king_pos_col;
-
-        if (dif_row == dif_col)
-        {
-            if (dif_row > 0)
-                return is_bishop_right_up_valid(pos_from_col, pos_from, pos_to);
-            else
-                return is_bishop_left_down_valid(pos_from_col, pos_from, pos_to);
-        }
-
-        if (dif_row == -dif_col)
+        if (white_to_move)
         {
-            if (dif_row > 0)
-                return is_bishop_left_up_valid(pos_from_col, pos_from, pos_to);
-            else
-                return is_bishop_right_down_valid(pos_from_col, pos_from, pos_to);
+            valid_moves.push_back(encode_move(piece_no_color_t::pawn, pos_from, pos_to, piece_t::white_queen));
+            valid_moves.push_back(encode_move(piece_no_color_t::pawn, pos_from, pos_to, piece_t::white_rook));
+            valid_moves.push_back(encode_move(piece_no_color_t::pawn, pos_from, pos_to, piece_t::white_bishop));
+            valid_moves.push_back(encode_move(piece_no_color_t::pawn, pos_from, pos_to, piece_t::white_knight));
         }
-
-        return true;
-    }
-
-    // checks if a move reveals an attack on the king
-    // if the king is already in check this method could return the weong result
-    // wich is if the king is in check every move is double check at the end of the generate_moves funcion
-    void add_move_with_control(vector<move_t>& valid_moves, piece_no_color_t moving_piece, int pos_from, int pos_to)
-    {
-        if (is_move_valid_fast_unsure(pos_from, pos_to) || is_move_valid(pos_from, pos_to))
-            valid_moves.emplace_back(encode_move(moving_piece, pos_from, pos_to));
-    }
-
-    // same method as add_move_with_control exept for en-pessant
-    void add_move_ep_with_control(vector<move_t>& valid_moves, piece_no_color_t moving_piece, int pos_from, int pos_to)
-    {
-        int takeover_pos;
-
-        if (pos_to > pos_from)
-            takeover_pos = pos_to - 8;
-        else
-            takeover_pos = pos_to + 8;
-
-        bit_reset(pawns, takeover_pos);
-        if (white_to_move)
-            bit_reset(black, takeover_pos);
-        else
-            bit_reset(white, takeover_pos);
-
-        bool valid_val1 = is_move_valid_fast_unsure(pos_from, pos_to) || is_move_valid(pos_from, pos_to);
-        bit_set(pawns, takeover_pos);
-        if (white_to_move)
-            bit_set(black, takeover_pos);
-        else
-            bit_set(white, takeover_pos);
-
-        if (!valid_val1)
-            return;
-
-        bit_reset(pawns, pos_from);
-        if (white_to_move)
-            bit_reset(white, pos_from);
         else
-            bit_reset(black, pos_from);
-
-        bool valid_val2 = is_move_valid_fast_unsure(takeover_pos, pos_to) || is_move_valid(takeover_pos, pos_to);
-        bit_set(pawns, pos_from);
-        if (white_to_move)
-            bit_set(white, pos_from);
-        else
-            bit_set(black, pos_from);
-
-        if (valid_val2)
-            valid_moves.push_back(encode_move(moving_piece, pos_from, pos_to));
-    }
-
-    // same method as add_move_with_control exept for promotion
-    void add_move_pr_with_control(vector<move_t>& valid_moves, vector<move_t>& candidate_moves, piece_no_color_t moving_piece, int pos_from, int pos_to, color_t piece_color)
-    {
-        if (is_move_valid_fast_unsure(pos_from, pos_to) || is_move_valid(pos_from, pos_to))
         {
-            if (piece_color == color_t::white)
-            {
-                valid_moves.push_back(encode_move(moving_piece, pos_from, pos_to, piece_t::white_queen));
-                valid_moves.push_back(encode_move(moving_piece, pos_from, pos_to, piece_t::white_rook));
-                valid_moves.push_back(encode_move(moving_piece, pos_from, pos_to, piece_t::white_bishop));
-                valid_moves.push_back(encode_move(moving_piece, pos_from, pos_to, piece_t::white_knight));
-            }
-            else
-            {
-                valid_moves.push_back(encode_move(moving_piece, pos_from, pos_to, piece_t::black_queen));
-                valid_moves.push_back(encode_move(moving_piece, pos_from, pos_to, piece_t::black_rook));
-                valid_moves.push_back(encode_move(moving_piece, pos_from, pos_to, piece_t::black_bishop));
-                valid_moves.push_back(encode_move(moving_piece, pos_from, pos_to, piece_t::black_knight));
-            }
+            valid_moves.push_back(encode_move(piece_no_color_t::pawn, pos_from, pos_to, piece_t::black_queen));
+            valid_moves.push_back(encode_move(piece_no_color_t::pawn, pos_from, pos_to, piece_t::black_rook));
+            valid_moves.push_back(encode_move(piece_no_color_t::pawn, pos_from, pos_to, piece_t::black_bishop));
+            valid_moves.push_back(encode_move(piece_no_color_t::pawn, pos_from, pos_to, piece_t::black_knight));
         }
     }
 
@@ -1046,8 +349,137 @@ class ChessBoard {
         white = black = kings = queens = rooks = bishops = knights = pawns = 0;
         castlings = 0;
         en_passant = ep_empty;
-        white_in_check = false;
-        black_in_check = false;
+        last_pawn_move = 0;
+        mailbox.fill(piece_t::empty);
+        hash_key = pawn_key = 0;
+        piece_square_score = 0;
+        endgame_material[0] = endgame_material[1] = 0;
+    }
+
+    // these methods change the bitboards, the mailbox, the hash keys and the evaluation sums together so they always agree
+    void set_piece(piece_t piece, square_t pos)
+    {
+        bit_set((int)piece < 8 ? white : black, *boards[(int)piece], pos);
+        mailbox[pos] = piece;
+        update_piece_keys(piece, pos);
+        add_piece_score(piece, pos);
+    }
+
+    void reset_piece(square_t pos)
+    {
+        piece_t piece = mailbox[pos];
+        bit_reset((int)piece < 8 ? white : black, *boards[(int)piece], pos);
+        mailbox[pos] = piece_t::empty;
+        update_piece_keys(piece, pos);
+        remove_piece_score(piece, pos);
+    }
+
+    void move_piece(square_t pos_from, square_t pos_to)
+    {
+        piece_t piece = mailbox[pos_from];
+        bit_move((int)piece < 8 ? white : black, *boards[(int)piece], pos_from, pos_to);
+        mailbox[pos_to] = piece;
+        mailbox[pos_from] = piece_t::empty;
+        update_piece_keys(piece, pos_from);
+        update_piece_keys(piece, pos_to);
+        piece_square_score += piece_square_scores[(int)piece][pos_to] - piece_square_scores[(int)piece][pos_from];
+    }
+
+    void add_piece_score(piece_t piece, square_t pos)
+    {
+        piece_square_score += piece_square_scores[(int)piece][pos];
+        endgame_material[(int)piece >= 8] += endgame_material_values[(int)piece % 8];
+    }
+
+    void remove_piece_score(piece_t piece, square_t pos)
+    {
+        piece_square_score -= piece_square_scores[(int)piece][pos];
+        endgame_material[(int)piece >= 8] -= endgame_material_values[(int)piece % 8];
+    }
+
+    // xors a piece in to (or out of) the keys
+    void update_piece_keys(piece_t piece, square_t pos)
+    {
+        hash_key ^= zobrist_keys.pieces[(int)piece][pos];
+
+        if (piece == piece_t::white_pawn || piece == piece_t::black_pawn)
+            pawn_key ^= zobrist_keys.pieces[(int)piece][pos];
+    }
+
+    // the part of the hash key that doesn't depend on the pieces
+    // move and undo_move xor it out before changing castlings, en-passant and the turn and xor the new one in afterwards
+    uint64_t state_key()
+    {
+        uint64_t key = zobrist_keys.castlings[castlings >> castling_shift];
+
+        if (en_passant != ep_empty)
+            key ^= zobrist_keys.en_passant[en_passant % 8];
+        if (!white_to_move)
+            key ^= zobrist_keys.black_to_move;
+
+        return key;
+    }
+
+    // computes both keys and the evaluation sums from scratch
+    void init_keys()
+    {
+        hash_key = state_key();
+        pawn_key = 0;
+        piece_square_score = 0;
+        endgame_material[0] = endgame_material[1] = 0;
+
+        for (square_t pos = 0; pos < 64; pos++)
+        {
+            if (mailbox[pos] != piece_t::empty)
+            {
+                update_piece_keys(mailbox[pos], pos);
+                add_piece_score(mailbox[pos], pos);
+            }
+        }
+    }
+
+    // finds the piece on a square by testing the bitboards
+    piece_t find_piece_type(uint32_t pos)
+    {
+        if (is_square_white(pos))
+        {
+            if (is_piece(pawns, pos))
+                return piece_t::white_pawn;
+            if (is_piece(knights, pos))
+                return piece_t::white_knight;
+            if (is_piece(bishops, pos))
+                return piece_t::white_bishop;
+            if (is_piece(rooks, pos))
+                return piece_t::white_rook;
+            if (is_piece(queens, pos))
+                return piece_t::white_queen;
+            if (is_piece(kings, pos))
+                return piece_t::white_king;
+        }
+        else if (is_square_black(pos))
+        {
+            if (is_piece(pawns, pos))
+                return piece_t::black_pawn;
+            if (is_piece(knights, pos))
+                return piece_t::black_knight;
+            if (is_piece(bishops, pos))
+                return piece_t::black_bishop;
+            if (is_piece(rooks, pos))
+                return piece_t::black_rook;
+            if (is_piece(queens, pos))
+                return piece_t::black_queen;
+            if (is_piece(kings, pos))
+                return piece_t::black_king;
+        }
+
+        return piece_t::empty;
+    }
+
+    // rebuilds the mailbox on the given squares from the bitboards
+    void update_mailbox(board_t squares)
+    {
+        for (; squares; squares &= squares - 1)
+            mailbox[bit_pos(squares)] = find_piece_type(bit_pos(squares));
     }
 
     int bit_pos_lsb(uint64_t x)
@@ -1076,40 +508,24 @@ class ChessBoard {
 
     vector<string> split(string s);
 
-    void generate_pawn_white_moves(vector<move_t>& valid_moves, vector<move_t>& candidate_moves, uint32_t pos, bool only_captures = false);
-    void generate_pawn_black_moves(vector<move_t>& valid_moves, vector<move_t>& candidate_moves, uint32_t pos, bool only_captures = false);
-
-    void generate_knight_all_moves(vector<move_t>& valid_moves, vector<move_t>& candidate_moves, uint32_t pos);
-    void generate_knight_capture_moves(vector<move_t>& valid_moves, vector<move_t>& candidate_moves, uint32_t pos);
-
-    void generate_bishop_all_moves(piece_no_color_t moving_piece, vector<move_t>& valid_moves, vector<move_t>& candidate_moves, uint32_t pos);
-    void generate_bishop_capture_moves(piece_no_color_t moving_piece, vector<move_t>& valid_moves, vector<move_t>& candidate_moves, uint32_t pos);
-
-    void generate_rook_all_moves(piece_no_color_t moving_piece, vector<move_t>& valid_moves, vector<move_t>& candidate_moves, uint32_t pos);
-    void generate_rook_capture_moves(piece_no_color_t moving_piece, vector<move_t>& valid_moves, vector<move_t>& candidate_moves, uint32_t pos);
-
-    void generate_queen_all_moves(vector<move_t>& valid_moves, vector<move_t>& candidate_moves, uint32_t pos);
-    void generate_queen_capture_moves(vector<move_t>& valid_moves, vector<move_t>& candidate_moves, uint32_t pos);
+    // computes king_pos, checkers, check_mask and pinned for the side to move
+    void init_legality_masks();
 
-    void generate_king_all_moves(vector<move_t>& valid_moves, vector<move_t>& candidate_moves, uint32_t pos);
-    void generate_king_capture_moves(vector<move_t>& valid_moves, vector<move_t>& candidate_moves, uint32_t pos);
+    // every move generated by these methods is legal
+    // targets is ~color_mask for all moves, opp_color_mask for captures or the empty squares for quiets
+    void generate_pawn_white_moves(MoveList& valid_moves, uint32_t pos, move_gen_t gen);
+    void generate_pawn_black_moves(MoveList& valid_moves, uint32_t pos, move_gen_t gen);
+    void generate_knight_moves(MoveList& valid_moves, uint32_t pos, board_t targets);
+    void generate_bishop_moves(piece_no_color_t moving_piece, MoveList& valid_moves, uint32_t pos, board_t targets);
+    void generate_rook_moves(piece_no_color_t moving_piece, MoveList& valid_moves, uint32_t pos, board_t targets);
+    void generate_queen_moves(MoveList& valid_moves, uint32_t pos, board_t targets);
+    void generate_king_moves(MoveList& valid_moves, uint32_t pos, board_t targets);
 
-    void add_en_passant(vector<move_t>& valid_moves, vector<move_t>& candidate_moves);
+    void add_en_passant(MoveList& valid_moves);
 
-    void add_castleing(vector<move_t>& valid_moves, vector<move_t>& candidate_moves);
+    void add_castleing(MoveList& valid_moves);
 
-    constexpr bool is_same_diagonal_or_line(int pos1, int pos2_row, int pos2_col)
-    {
-        int pos1_row = get_row(pos1);
-        int pos1_col = get_col(pos1);
-
-        if (pos1_row == pos2_row)
-            return true;
-        if (pos1_col == pos2_col)
-            return true;
-
-        return abs(pos1_row - pos2_row) == abs(pos1_col - pos2_col);
-    }
+    void generate(MoveList& valid_moves, move_gen_t gen);
 
     constexpr bool is_en_passant_takeover(uint32_t pos_to, piece_no_color_t moving_piece)
     {
@@ -1121,11 +537,6 @@ class ChessBoard {
         return is_en_passant_takeover(get_move_to(move), get_moving_piece(move));
     }
 
-    constexpr bool is_same_diagonal_or_line(int pos1, int pos2)
-    {
-        return is_same_diagonal_or_line(pos1, pos2 / 8, pos2 % 8);
-    }
-
     void test_board()
     {
         if (white & black)
@@ -1137,21 +548,19 @@ class ChessBoard {
         }
     }
 
-    int king_pos, king_pos_row, king_pos_col;
-    int opp_king_pos;
-    board_t opp_king_attacking_mask;
-    bool white_in_check;
-    bool black_in_check;
+    int king_pos;
     bool king_in_check;
 
     board_t color_mask, opp_color_mask;
-    color_t piece_color;
 
-    board_t b_attacking_queens;
-    board_t b_attacking_rooks;
-    board_t b_attacking_bishops;
-    board_t b_need_inspection;
-    bool all_safe;
+    // https://www.chessprogramming.org/Checks_and_Pinned_Pieces_(Bitboards)
+    // checkers - enemy pieces giving check
+    // check_mask - squares a non king move has to end on: everything when not in check,
+    //              the checker and the squares between it and the king in a single check, nothing in a double check
+    // pinned - own pieces that can only move along the line to the king
+    board_t checkers;
+    board_t check_mask;
+    board_t pinned;
 
     // allows faster acces a bitboard since we dont need to use a switch statement 
     array<uint64_t*, 16> boards;
@@ -1185,8 +594,22 @@ public:
     board_t knights;
     board_t pawns;
 
+    // piece on every square, kept in sync with the bitboards by move, undo_move, from_fen and set_position
+    array<piece_t, 64> mailbox;
+
+    // https://www.chessprogramming.org/Zobrist_Hashing
+    // hash_key identifies the whole position, pawn_key only the pawns, both are updated with every move
+    uint64_t hash_key;
+    uint64_t pawn_key;
+
+    // material and piece square tables of both sides (from whites point of view) and the endgame material of white [0] and black [1]
+    // the evaluation reads these instead of going through the pieces
+    score_t piece_square_score;
+    int endgame_material[2];
+
     unsigned castlings;
     unsigned en_passant;
+    // plies since the last pawn move or capture (the halfmove clock of the fen)
     int last_pawn_move;
     bool white_to_move;
     vector<move_log_t> move_log;
@@ -1209,27 +632,24 @@ public:
         pawns = rhs.pawns;
         castlings = rhs.castlings;
         en_passant = rhs.en_passant;
+        mailbox = rhs.mailbox;
+        hash_key = rhs.hash_key;
+        pawn_key = rhs.pawn_key;
+        piece_square_score = rhs.piece_square_score;
+        endgame_material[0] = rhs.endgame_material[0];
+        endgame_material[1] = rhs.endgame_material[1];
 
         init_boards();
 
         king_pos = rhs.king_pos;
-        king_pos_row = rhs.king_pos_row;
-        king_pos_col = rhs.king_pos_col;
-        opp_king_pos = rhs.opp_king_pos;
-        opp_king_attacking_mask = rhs.opp_king_attacking_mask;
-        white_in_check = rhs.white_in_check;
-        black_in_check = rhs.black_in_check;
         king_in_check = rhs.king_in_check;
 
         color_mask = rhs.color_mask;
         opp_color_mask = rhs.opp_color_mask;
-        piece_color = rhs.piece_color;
 
-        b_attacking_queens = rhs.b_attacking_queens;
-        b_attacking_rooks = rhs.b_attacking_rooks;
-        b_attacking_bishops = rhs.b_attacking_bishops;
-        b_need_inspection = rhs.b_need_inspection;
-        all_safe = rhs.all_safe;
+        checkers = rhs.checkers;
+        check_mask = rhs.check_mask;
+        pinned = rhs.pinned;
 
         last_pawn_move = rhs.last_pawn_move;
         move_log = rhs.move_log;
@@ -1248,27 +668,24 @@ public:
         pawns = x.pawns;
         castlings = x.castlings;
         en_passant = x.en_passant;
+        mailbox = x.mailbox;
+        hash_key = x.hash_key;
+        pawn_key = x.pawn_key;
+        piece_square_score = x.piece_square_score;
+        endgame_material[0] = x.endgame_material[0];
+        endgame_material[1] = x.endgame_material[1];
 
         init_boards();
 
         king_pos = x.king_pos;
-        king_pos_row = x.king_pos_row;
-        king_pos_col = x.king_pos_col;
-        opp_king_pos = x.opp_king_pos;
-        opp_king_attacking_mask = x.opp_king_attacking_mask;
-        white_in_check = x.white_in_check;
-        black_in_check = x.black_in_check;
         king_in_check = x.king_in_check;
 
         color_mask = x.color_mask;
         opp_color_mask = x.opp_color_mask;
-        piece_color = x.piece_color;
 
-        b_attacking_queens = x.b_attacking_queens;
-        b_attacking_rooks = x.b_attacking_rooks;
-        b_attacking_bishops = x.b_attacking_bishops;
-        b_need_inspection = x.b_need_inspection;
-        all_safe = x.all_safe;
+        checkers = x.checkers;
+        check_mask = x.check_mask;
+        pinned = x.pinned;
 
         last_pawn_move = x.last_pawn_move;
         move_log = x.move_log;
@@ -1331,11 +748,6 @@ public:
         return b & (1ull << pos);
     }
 
-    constexpr board_t square_mask(int row, int col)
-    {
-        return 1ull << (8 * row + col);
-    }
-
     constexpr move_t get_ep(move_t x) {
         return ((x >> ep_shift) & ep_mask) + 16;
     }
@@ -1391,6 +803,11 @@ public:
 
     bool in_check();
 
+    // false for positions the move generator can't handle (read from a broken fen or epd):
+    // not exactly one king per side, a pawn on the first or last rank, the side that just moved in check,
+    // a castling right without the king and the rook on their starting squares or an en-passant square without the pawn that skipped it
+    bool is_legal_position();
+
     // converts a move from move_t to uci notation (*start square* *end square*)
     // for example: e2e4
     string move_t_to_uci(move_t chess_move)
@@ -1420,7 +837,8 @@ public:
         if (uci_move.size() == 5)
             promotion = (int)promotion_board.find(uci_move[4]);
 
-        if (promotion && uci_move[1] == '1')
+        // black pieces are 8 higher than the white ones
+        if (promotion && !white_to_move)
             promotion += 8;
 
         auto piece = get_piece_type(((int)uci_move[1] - '1') * 8 + ((int)uci_move[0] - 'a'));
@@ -1445,40 +863,23 @@ public:
         return (piece_t)((x >> promotion_shift) & piece_mask);
     }
 
-    piece_t get_piece_type(uint32_t pos)
+    // the from, to and promotion bits of a move, used where memory is tight (transposition table)
+    constexpr uint16_t get_short_move(move_t x) {
+        return (uint16_t)(x & short_move_mask);
+    }
+
+    // adds the moving piece back from the board, so it only makes sense in the position the move was saved in
+    move_t from_short_move(uint16_t x)
     {
-        if (is_square_white(pos))
-        {
-            if (is_piece(pawns, pos))
-                return piece_t::white_pawn;
-            if (is_piece(knights, pos))
-                return piece_t::white_knight;
-            if (is_piece(bishops, pos))
-                return piece_t::white_bishop;
-            if (is_piece(rooks, pos))
-                return piece_t::white_rook;
-            if (is_piece(queens, pos))
-                return piece_t::white_queen;
-            if (is_piece(kings, pos))
-                return piece_t::white_king;
-        }
-        else if (is_square_black(pos))
-        {
-            if (is_piece(pawns, pos))
-                return piece_t::black_pawn;
-            if (is_piece(knights, pos))
-                return piece_t::black_knight;
-            if (is_piece(bishops, pos))
-                return piece_t::black_bishop;
-            if (is_piece(rooks, pos))
-                return piece_t::black_rook;
-            if (is_piece(queens, pos))
-                return piece_t::black_queen;
-            if (is_piece(kings, pos))
-                return piece_t::black_king;
-        }
+        if (x == 0)
+            return 0;
 
-        return piece_t::empty;
+        return x | (((move_t)mailbox[get_move_from(x)] % 8) << moving_piece_shift);
+    }
+
+    piece_t get_piece_type(uint32_t pos)
+    {
+        return mailbox[pos];
     }
 
     constexpr move_t encode_move(piece_no_color_t moving_piece, uint32_t from, uint32_t to, piece_t promotion)
@@ -1500,38 +901,113 @@ public:
     string get_fen();
     void visualise();
 
+    // pieces of both colors attacking square pos, sliders are blocked by occupied
+    board_t attackers_to(uint32_t pos, board_t occupied)
+    {
+        return (pawn_attack_masks[0][pos] & black & pawns) |
+            (pawn_attack_masks[1][pos] & white & pawns) |
+            (attacking_mask_knight[pos] & knights) |
+            (attacking_mask_king[pos] & kings) |
+            (rook_attacks(pos, occupied) & (rooks | queens)) |
+            (bishop_attacks(pos, occupied) & (bishops | queens));
+    }
+
     inline bool is_attacked(uint32_t pos, bool white_move);
 
     vector<move_t> generate_capture_moves();
     vector<move_t> generate_moves();
 
-    void move(move_t move);
-    void undo_move();
-    void no_move();
+    // same as above but the moves are written to a list owned by the caller so nothing is allocated on the heap
+    void generate_capture_moves(MoveList& valid_moves);
+    void generate_moves(MoveList& valid_moves);
+
+    // every move that isn't generated by generate_capture_moves
+    void generate_quiet_moves(MoveList& valid_moves);
 
+    // checks if a move (for example from the transposition table or a killer move) can be played in the current position
+    bool is_move_legal(move_t chess_move);
 
-    void get_board_state(board_state_t& state)
+    constexpr bool is_capture(move_t chess_move)
     {
-        state.white = white;
-        state.black = black;
-        state.kings = kings;
-        state.queens = queens;
-        state.rooks = rooks;
-        state.bishops = bishops;
-        state.knights = knights;
-        state.pawns = pawns;
-        state.metadata = ((uint64_t)castlings) << 32;
-        state.metadata += ((uint64_t)(en_passant - 16)) << (32 + ep_shift);
-        state.metadata += ((uint64_t)white_to_move) << 31;
+        return is_square_occupied(get_move_to(chess_move)) || is_en_passant_takeover(chess_move);
     }
-};
 
-template <>
-struct hash<board_state_t>
-{
-    size_t operator()(const board_state_t& k) const
+    /*
+    https://www.chessprogramming.org/Static_Exchange_Evaluation
+    material won (or lost when negative) by a capture if both sides keep recapturing on the target square with their least valuable piece,
+    each side can also stop when recapturing would lose more. pins and checks are ignored
+    */
+    int see(move_t chess_move);
+
+    // the full exchange is only evaluated when the capturing piece is worth more than the captured one
+    bool is_losing_capture(move_t chess_move)
     {
-        return
-            hash<uint64_t>()((k.white * 3) ^ (k.black * 5) ^ (k.kings * 7) ^ (k.queens * 11) ^ (k.rooks * 13) ^ (k.bishops * 17) ^ (k.knights * 19) ^ (k.pawns * 23) ^ (k.metadata * 29));
+        piece_t victim = get_piece_type(get_move_to(chess_move));
+        int victim_value = victim == piece_t::empty ? see_values[(int)piece_no_color_t::pawn] : see_values[(int)victim % 8];
+
+        if (victim_value >= see_values[(int)get_piece_type(get_move_from(chess_move)) % 8])
+            return false;
+
+        return see(chess_move) < 0;
+    }
+
+    void move(move_t move);
+    void undo_move();
+    void no_move();
+
+    // copy-make alternative to undo_move()
+    // the position saved before move() or no_move() is copied back and the move is removed from the log
+    void undo_move(const Position& position)
+    {
+        set_position(position);
+        move_log.pop_back();
+    }
+
+    void get_position(Position& position)
+    {
+        position.white = white;
+        position.black = black;
+        position.kings = kings;
+        position.queens = queens;
+        position.rooks = rooks;
+        position.bishops = bishops;
+        position.knights = knights;
+        position.pawns = pawns;
+        position.hash_key = hash_key;
+        position.pawn_key = pawn_key;
+        position.piece_square_score = piece_square_score;
+        position.endgame_material[0] = (uint8_t)endgame_material[0];
+        position.endgame_material[1] = (uint8_t)endgame_material[1];
+        position.castlings = (uint8_t)(castlings >> castling_shift);
+        position.en_passant = (uint8_t)en_passant;
+        position.last_pawn_move = (uint16_t)last_pawn_move;
+        position.white_to_move = white_to_move;
+    }
+
+    void set_position(const Position& position)
+    {
+        // only the squares where some bitboard differs have to be updated in the mailbox
+        board_t changed = (white ^ position.white) | (black ^ position.black) | (kings ^ position.kings) | (queens ^ position.queens) |
+            (rooks ^ position.rooks) | (bishops ^ position.bishops) | (knights ^ position.knights) | (pawns ^ position.pawns);
+
+        white = position.white;
+        black = position.black;
+        kings = position.kings;
+        queens = position.queens;
+        rooks = position.rooks;
+        bishops = position.bishops;
+        knights = position.knights;
+        pawns = position.pawns;
+        hash_key = position.hash_key;
+        pawn_key = position.pawn_key;
+        piece_square_score = position.piece_square_score;
+        endgame_material[0] = position.endgame_material[0];
+        endgame_material[1] = position.endgame_material[1];
+        castlings = (unsigned)position.castlings << castling_shift;
+        en_passant = position.en_passant;
+        last_pawn_move = position.last_pawn_move;
+        white_to_move = position.white_to_move;
+
+        update_mailbox(changed);
     }
 };
\ No newline at end of file
@@ -1,59 +1,191 @@
 #pragma once
 #include <bit>
 #include <iostream>
-#include <unordered_map>
 #include <cmath>
 #include <thread>
 #include <chrono>
 #include <atomic>
+#include <climits>
+#include <memory>
+#include <vector>
 
 #include "board.h"
+#include "move_picker.h"
+#include "transposition_table.h"
+#include "repetition_history.h"
+#include "pawn_hash_table.h"
+#include "eval_cache.h"
+#include "time_manager.h"
+#include "search_stats.h"
+#include "search_parameters.h"
 
 using namespace std;
 
-enum class node_type_t
+// how the main search reports every finished depth
+enum class info_output_t
 {
-	exact = 0,
-	lower_bound = 1,
-	upper_bound = 2,
+	none = 0,
+	text = 1,
+	// one json line per depth and a summary of the whole search at the end
+	json = 2,
+	// info lines of the universal chess interface
+	uci = 3,
 };
-struct transposition_table_entry
-{
-	transposition_table_entry() = default;
-	transposition_table_entry(const transposition_table_entry&) = default;
 
-	node_type_t node_type;
-	move_t move;
-	int depth;
-	int eval;
+// one line of the multipv search, the principal variation starts with the root move
+struct search_line_t
+{
+	vector<move_t> pv;
+	int eval = 0;
+	int depth = 0;
 };
 
+constexpr board_t generate_passed_pawn_mask(int square, bool color)
+{
+	/*
+	generates a mask of every square in front of the pawn on surrounding and current file
+	if there is no oppont pawns on this mask it means that the pawn has a clear path to promotion
+	and should be given extra value
+	*/
+
+	int file = square % 8;
+	int rank = square / 8;
+
+	if (rank == 7 || rank == 0)
+		return 0;
+
+	board_t file_a_mask = 0x0101010101010101;
+
+	board_t file_mask_center = file_a_mask << file;
+	board_t file_mask_left = file_a_mask << max(0, file - 1);
+	board_t file_mask_right = file_a_mask << min(7, file + 1);
+
+	board_t files_mask = file_mask_left | file_mask_center | file_mask_right;
+
+	board_t up_mask = 0;
+	if (color)
+		up_mask = ULLONG_MAX << 8 * (rank + 1);
+	else
+		up_mask = ULLONG_MAX >> 8 * (7 - rank);
+
+	return files_mask & up_mask;
+}
+
+// color: true - white, false - black
+constexpr board_t generate_king_attack_mask(int square, bool color)
+{
+	/*
+	adds another 3 spaces in front of the current king mask
+	a simmilar aproch (6 spaces insted of 3) is used by stockfish
+	*/
+	board_t mask = attacking_mask_king[square];
+
+	if (color)
+	{
+		if (square % 8 && square + 15 < 64)
+			mask |= 1ull << (square + 15);
+		if (square + 16 < 64)
+			mask |= 1ull << (square + 16);
+		if (square % 8 != 7 && square + 17 < 64)
+			mask |= 1ull << (square + 17);
+	}
+	else
+	{
+		if (square % 8 != 7 && square - 15 >= 0)
+			mask |= 1ull << (square - 15);
+		if (square - 16 >= 0)
+			mask |= 1ull << (square - 16);
+		if (square % 8 && square - 17 >= 0)
+			mask |= 1ull << (square - 17);
+	}
+
+	return mask;
+}
+
+// the evaluation masks are shared by every Computer and computed at compile time
+inline constexpr array<board_t, 64> white_passed_pawn_masks = square_table([](int row, int col) { return generate_passed_pawn_mask(8 * row + col, true); });
+inline constexpr array<board_t, 64> black_passed_pawn_masks = square_table([](int row, int col) { return generate_passed_pawn_mask(8 * row + col, false); });
+inline constexpr array<board_t, 64> white_king_attack_mask = square_table([](int row, int col) { return generate_king_attack_mask(8 * row + col, true); });
+inline constexpr array<board_t, 64> black_king_attack_mask = square_table([](int row, int col) { return generate_king_attack_mask(8 * row + col, false); });
+
 class Computer
 {
 	const static int max_depth = 99;
-	const static int RFP_margin = 75;
-	const static int null_move_pruning_cutof = 2;
-
-	const static int pawns_value = 100;
-	const static int knight_value = 300;
-	const static int bishop_value = 325;
-	const static int rook_value = 500;
-	const static int queen_value = 900;
+
+	const static int pawns_value = piece_values[(int)piece_no_color_t::pawn];
+	const static int knight_value = piece_values[(int)piece_no_color_t::knight];
+	const static int bishop_value = piece_values[(int)piece_no_color_t::bishop];
+	const static int rook_value = piece_values[(int)piece_no_color_t::rook];
+	const static int queen_value = piece_values[(int)piece_no_color_t::queen];
 	const static int check_mate_eval = 1'000'000;
 	const static int endgame_material_start = 12;
+	static constexpr int default_hash_size_mb = 64;
+	const static int default_pawn_hash_size_mb = 2;
+	static constexpr int default_eval_cache_size_mb = 8;
+	// mate evals are saved around this value in the transposition table (it only has 16 bits for an eval)
+	const static int transposition_mate_eval = 32'000;
+	const static int mate_eval_range = 1'000;
+	// the clock is read once every this many nodes (has to be a power of 2)
+	const static uint64_t time_check_interval = 1024;
 
 	ChessBoard board;
-	vector<board_state_t> board_history;
-	vector<board_state_t> board_history_search;
-	unordered_map<board_state_t, transposition_table_entry> transposition_table;
+	RepetitionHistory repetitions;
+	// shared by the main search and all the helper threads
+	shared_ptr<TranspositionTable> transposition_table;
+	shared_ptr<EvalCache> eval_cache;
+
+	// https://www.chessprogramming.org/Lazy_SMP
+	// every helper has its own board, history and killers and searches the same position as the main search,
+	// the only thing they share is the transposition table so the threads mostly speed each other up through it
+	vector<unique_ptr<Computer>> helpers;
+
+	PawnHashTable pawn_hash_table{ default_pawn_hash_size_mb };
 
 	long quiet_history[4096];
 	move_t killers[max_depth];
 
-	int eval_count = 0;
-	int transposition_count = 0;
+	SearchStats stats;
+	// the node count of stats copied every time_check_interval nodes, so the main thread can read the nodes of the running helpers
+	atomic<uint64_t> published_nodes = 0;
+	info_output_t info_output = info_output_t::text;
+
+	search_parameters_t parameters;
 
 	atomic<bool> search_canceled;
+	// only the main search has limits, the helpers are stopped by it
+	search_limits_t search_limits;
+	TimeManager time_manager;
+
+	// result of the deepest iteration this thread has finished
+	int completed_depth = 0;
+	pair<move_t, int> best_root_move;
+
+	// https://www.chessprogramming.org/Root
+	// the root moves are generated once per search and go through this list instead of a move picker.
+	// after every search of the root they are sorted by the evals they got, so every depth (and every multipv line)
+	// starts with the moves that were best the last time
+	struct root_move_t
+	{
+		move_t chess_move;
+		int eval;
+	};
+	vector<root_move_t> root_moves;
+
+	// https://www.chessprogramming.org/Multiple_PV
+	// every line searches the root again without the moves of the lines found before it (they are moved to the front of root_moves),
+	// the lines share the transposition table so the later ones mostly run through positions the first one already visited
+	int multi_pv = 1;
+	uint32_t root_excluded_count = 0;
+	vector<search_line_t> pv_lines;
+
+	// https://www.chessprogramming.org/Pondering
+	// the search on the opponent's time runs on its own thread in the position after the expected reply,
+	// the position before the reply is kept to go back to it when the opponent plays something else
+	thread ponder_thread;
+	move_t ponder_move = null_move;
+	pair<move_t, int> ponder_result;
+	ChessBoard board_before_ponder;
+	RepetitionHistory repetitions_before_ponder;
 
 	int passed_pawn_bonus[7] = { 0, 120, 80, 50, 30, 15, 15 };
 
@@ -81,106 +213,6 @@ class Computer
 		10, 15, 0, 0, 5, 5
 	};
 
-	board_t white_passed_pawn_masks[64];
-	board_t black_passed_pawn_masks[64];
-	board_t white_king_attack_mask[64];
-	board_t black_king_attack_mask[64];
-
-	int pawns_early_square_table_white[64] = {
-		 0,  0,  0,  0,  0,  0,  0,  0,
-		50, 50, 50, 50, 50, 50, 50, 50,
-		10, 10, 20, 30, 30, 20, 10, 10,
-		 5,  5, 10, 25, 25, 10,  5,  5,
-		 0,  0,  0, 20, 20,  0,  0,  0,
-		 5, -5,-10,  0,  0,-10, -5,  5,
-		 5, 10, 10,-20,-20, 10, 10,  5,
-		 0,  0,  0,  0,  0,  0,  0,  0
-	};
-	int pawns_end_square_table_white[64] = {
-		 0,  0,  0,  0,  0,  0,  0,  0,
-		90, 95, 90, 80, 80, 90, 95, 90,
-		50, 70, 50, 45, 45, 50, 70, 50,
-		23, 25, 23, 18, 18, 23, 25, 23,
-		15, 18, 15, 15, 15, 15, 18, 15,
-		15, 15, 15, 15, 15, 15, 15, 15,
-		15, 15, 15, 18, 18, 15, 15, 15,
-		 0,  0,  0,  0,  0,  0,  0,  0
-	};
-	int rooks_square_table_white[64] = {
-		 0,  0,  0,  0,  0,  0,  0,  0,
-		 5, 10, 10, 10, 10, 10, 10,  5,
-		-5,  0,  0,  0,  0,  0,  0, -5,
-		-5,  0,  0,  0,  0,  0,  0, -5,
-		-5,  0,  0,  0,  0,  0,  0, -5,
-		-5,  0,  0,  0,  0,  0,  0, -5,
-		-5,  0,  0,  0,  0,  0,  0, -5,
-		 0,  0,  0,  5,  5,  0,  0,  0
-	};
-	int knights_square_table_white[64] = {
-		-50,-40,-30,-30,-30,-30,-40,-50,
-		-40,-20,  0,  0,  0,  0,-20,-40,
-		-30,  0, 10, 15, 15, 10,  0,-30,
-		-30,  5, 15, 20, 20, 15,  5,-30,
-		-30,  0, 15, 20, 20, 15,  0,-30,
-		-30,  5, 10, 15, 15, 10,  5,-30,
-		-40,-20,  0,  5,  5,  0,-20,-40,
-		-50,-40,-30,-30,-30,-30,-40,-50,
-	};
-	int bishops_square_table_white[64] = {
-		-20,-10,-10,-10,-10,-10,-10,-20,
-		-10,  0,  0,  0,  0,  0,  0,-10,
-		-10,  0,  5, 10, 10,  5,  0,-10,
-		-10,  5,  5, 10, 10,  5,  5,-10,
-		-10,  0, 10, 10, 10, 10,  0,-10,
-		-10, 10, 10, 10, 10, 10, 10,-10,
-		-10,  5,  0,  0,  0,  0,  5,-10,
-		-20,-10,-10,-10,-10,-10,-10,-20,
-	};
-	int queens_square_table_white[64] = {
-		-20,-10,-10, -5, -5,-10,-10,-20,
-		-10,  0,  0,  0,  0,  0,  0,-10,
-		-10,  0,  5,  5,  5,  5,  0,-10,
-		 -5,  0,  5,  5,  5,  5,  0, -5,
-		  0,  0,  5,  5,  5,  5,  0, -5,
-		-10,  5,  5,  5,  5,  5,  0,-10,
-		-10,  0,  5,  0,  0,  0,  0,-10,
-		-20,-10,-10, -5, -5,-10,-10,-20
-	};
-	int king_early_square_table_white[64] = {
-		-80,-70,-70,-70,-70,-70,-70,-80,
-		-60,-60,-60,-60,-60,-60,-60,-60,
-		-40,-50,-50,-60,-60,-50,-50,-40,
-		-30,-40,-40,-50,-50,-40,-40,-30,
-		-20,-30,-30,-40,-40,-30,-30,-20,
-		-10,-20,-20,-20,-20,-20,-20,-10,
-		 20, 20, -5, -5, -5, -5, 20, 20,
-		 20, 30, 10,  0,  0, 10, 30, 20
-	};
-	int king_end_square_table_white[64] = {
-		-50,-40,-30,-20,-20,-30,-40,-50,
-		-30,-20,-10,  0,  0,-10,-20,-30,
-		-30,-10, 20, 30, 30, 20,-10,-30,
-		-30,-10, 30, 40, 40, 30,-10,-30,
-		-30,-10, 30, 40, 40, 30,-10,-30,
-		-30,-10, 20, 30, 30, 20,-10,-30,
-		-30,-30,  0,  0,  0,  0,-30,-30,
-		-50,-30,-30,-30,-30,-30,-30,-50
-	};
-	int pawns_early_square_table_black[64];
-	int pawns_end_square_table_black[64];
-	int rooks_square_table_black[64];
-	int knights_square_table_black[64];
-	int bishops_square_table_black[64];
-	int queens_square_table_black[64];
-	int king_early_square_table_black[64];
-	int king_end_square_table_black[64];
-
-	void mirror_array(int* a, int* b)
-	{
-		for (int i = 0; i < 64; i++)
-			b[8 * (7 - i / 8) + (i % 8)] = a[i];
-	}
-
 	int get_piece_value(piece_t piece)
 	{
 		switch (piece)
@@ -216,43 +248,10 @@ class Computer
 		}
 	}
 
-	int count_material()
-	{
-		int output = 0;
-		output += (int)__popcnt64(board.white & board.pawns) * pawns_value;
-		output += (int)__popcnt64(board.white & board.knights) * knight_value;
-		output += (int)__popcnt64(board.white & board.bishops) * bishop_value;
-		output += (int)__popcnt64(board.white & board.rooks) * rook_value;
-		output += (int)__popcnt64(board.white & board.queens) * queen_value;
-
-		output -= (int)__popcnt64(board.black & board.pawns) * pawns_value;
-		output -= (int)__popcnt64(board.black & board.knights) * knight_value;
-		output -= (int)__popcnt64(board.black & board.bishops) * bishop_value;
-		output -= (int)__popcnt64(board.black & board.rooks) * rook_value;
-		output -= (int)__popcnt64(board.black & board.queens) * queen_value;
-
-		return output;
-	}
 	// color: true - white, false - black
 	float count_endgame_material(bool colour)
 	{
-		int output = 0;
-		if (colour)
-		{
-			output += (int)__popcnt64(board.white & board.knights) * 1;
-			output += (int)__popcnt64(board.white & board.bishops) * 1;
-			output += (int)__popcnt64(board.white & board.rooks) * 2;
-			output += (int)__popcnt64(board.white & board.queens) * 4;
-		}
-		else
-		{
-			output += (int)__popcnt64(board.black & board.knights) * 1;
-			output += (int)__popcnt64(board.black & board.bishops) * 1;
-			output += (int)__popcnt64(board.black & board.rooks) * 2;
-			output += (int)__popcnt64(board.black & board.queens) * 4;
-		}
-
-		return output;
+		return board.endgame_material[colour ? 0 : 1];
 	}
 
 	float get_endgame_weight(float endgame_material)
@@ -261,112 +260,6 @@ class Computer
 		return 1 - min(1.0f, endgame_material * multiplier);
 	}
 
-	int compare_table_with_mask(const int table[64], board_t mask)
-	{
-		int eval = 0;
-		int dif;
-		square_t square = -1;
-
-		while (mask)
-		{
-			dif = board.bit_pos(mask);
-			mask = mask >> dif >> 1;
-			square += dif + 1;
-			int mirror_square = 8 * (7 - square / 8) + (square % 8);
-
-			eval += table[mirror_square];
-		}
-		return eval;
-	}
-
-	// color: true - white, false - black
-	int evaluate_piece_square_tables(bool color, float endgame_weight)
-	{
-		/*
-		https://www.chessprogramming.org/Piece-Square_Tables
-		aprart of incentivising active play piece square tables also implicidly ealuate space and king safety
-		*/
-		board_t color_mask = color ? board.white : board.black;
-		int eval = compare_table_with_mask(color ? knights_square_table_white : knights_square_table_black, color_mask & board.knights);
-		eval += compare_table_with_mask(color ? bishops_square_table_white : bishops_square_table_black, color_mask & board.bishops);
-		eval += compare_table_with_mask(color ? rooks_square_table_white : rooks_square_table_black, color_mask & board.rooks);
-		eval += compare_table_with_mask(color ? queens_square_table_white : queens_square_table_black, color_mask & board.queens);
-
-		int king_early_eval = compare_table_with_mask(color ? king_early_square_table_white : king_early_square_table_black, color_mask & board.kings);
-		int king_end_eval = compare_table_with_mask(color ? king_end_square_table_white : king_end_square_table_black, color_mask & board.kings);
-		eval += (int)(king_early_eval * (1 - endgame_weight));
-		eval += (int)(king_end_eval * endgame_weight);
-
-		int pawns_early_eval = compare_table_with_mask(color ? pawns_early_square_table_white : pawns_early_square_table_black, color_mask & board.pawns);
-		int pawns_end_eval = compare_table_with_mask(color ? pawns_end_square_table_white : pawns_end_square_table_black, color_mask & board.pawns);
-		eval += (int)(pawns_early_eval * (1 - endgame_weight));
-		eval += (int)(pawns_end_eval * endgame_weight);
-
-		return eval;
-	}
-
-	constexpr board_t generate_passed_pawn_mask(square_t square, bool color)
-	{
-		/*
-		generates a mask of every square in front of the pawn on surrounding and current file
-		if there is no oppont pawns on this mask it means that the pawn has a clear path to promotion
-		and should be given extra value
-		*/
-
-		int file = square % 8;
-		int rank = square / 8;
-
-		if (rank == 7 || rank == 0)
-			return 0;
-
-		board_t file_a_mask = 0x0101010101010101;
-
-		board_t file_mask_center = file_a_mask << file;
-		board_t file_mask_left = file_a_mask << max(0, file - 1);
-		board_t file_mask_right = file_a_mask << min(7, file + 1);
-
-		board_t files_mask = file_mask_left | file_mask_center | file_mask_right;
-
-		board_t up_mask = 0;
-		if (color)
-			up_mask = ULLONG_MAX << 8 * (rank + 1);
-		else
-			up_mask = ULLONG_MAX >> 8 * (7 - rank);
-
-		return files_mask & up_mask;
-	}
-
-	// color: true - white, false - black
-	board_t generate_king_attack_mask(square_t square, bool color)
-	{
-		/*
-		adds another 3 spaces in front of the current king mask
-		a simmilar aproch (6 spaces insted of 3) is used by stockfish
-		*/
-		board_t mask = board.get_attacking_mask_king(square);
-
-		if (color)
-		{
-			if (square % 8 && square + 15 < 64)
-				mask |= 1ull << (square + 15);
-			if (square + 16 < 64)
-				mask |= 1ull << (square + 16);
-			if (square % 8 != 7 && square + 17 < 64)
-				mask |= 1ull << (square + 17);
-		}
-		else
-		{
-			if (square % 8 && square - 15 >= 0)
-				mask |= 1ull << (square - 15);
-			if (square - 16 >= 0)
-				mask |= 1ull << (square - 16);
-			if (square % 8 != 7 && square - 17 >= 0)
-				mask |= 1ull << (square - 17);
-		}
-
-		return mask;
-	}
-
 	// color: true - white, false - black
 	board_t get_passed_pawn_pask(square_t square, bool color)
 	{
@@ -377,33 +270,74 @@ class Computer
 	}
 
 	// color: true - white, false - black
-	int evaluate_passed_pawns(bool color)
+	// fills in the passed pawns, the files without pawns and the lone pawns of one side
+	void evaluate_pawn_structure(pawn_hash_entry& entry, bool color)
 	{
 		board_t my_color_mask = color ? board.white : board.black;
 		board_t enemy_color_mask = !color ? board.white : board.black;
 		board_t my_mask = my_color_mask & board.pawns;
 		board_t enemy_mask = enemy_color_mask & board.pawns;
+		int side = color ? 0 : 1;
 
-		int eval = 0;
-		int dif;
-		square_t square = -1;
+		entry.passed_pawns[side] = 0;
+		entry.passed_pawn_score[side] = 0;
+		entry.semi_open_files[side] = 0;
+		entry.lone_pawns[side] = 0;
 
-		while (my_mask)
+		for (board_t b = my_mask; b; b &= b - 1)
 		{
-			dif = board.bit_pos(my_mask);
-			my_mask = my_mask >> dif >> 1;
-			square += dif + 1;
-
+			square_t square = board.bit_pos(b);
 			board_t passed_pawn_mask = get_passed_pawn_pask(square, color);
 
 			if (!(enemy_mask & passed_pawn_mask))
 			{
 				int squares_to_promotion = color ? 7 - square / 8 : square / 8;
-				eval += passed_pawn_bonus[squares_to_promotion];
+				entry.passed_pawns[side] |= 1ull << square;
+				entry.passed_pawn_score[side] += passed_pawn_bonus[squares_to_promotion];
 			}
 		}
 
-		return eval;
+		for (int file = 0; file < 8; file++)
+		{
+			board_t file_mask = 0x0101010101010101ull << file;
+			int pawns_on_file = (int)__popcnt64(file_mask & my_mask);
+
+			if (pawns_on_file == 0)
+				entry.semi_open_files[side] |= file_mask;
+			if (pawns_on_file == 1)
+				entry.lone_pawns[side]++;
+		}
+	}
+
+	// looks the pawn structure up in the pawn hash table and computes it if it isn't there
+	// the shelter is recomputed for a king that moved since the entry was saved
+	pawn_hash_entry& get_pawn_entry()
+	{
+		bool found;
+		pawn_hash_entry& entry = pawn_hash_table.probe(board.pawn_key, found);
+
+		if (!found)
+		{
+			entry.key = board.pawn_key;
+			entry.filled = true;
+			evaluate_pawn_structure(entry, true);
+			evaluate_pawn_structure(entry, false);
+			entry.king_square[0] = entry.king_square[1] = 64;
+		}
+
+		for (int side = 0; side < 2; side++)
+		{
+			square_t king_square = board.get_king_pos(side == 0);
+			if (entry.king_square[side] == king_square)
+				continue;
+
+			// the more pawns there are in front of the king the more protection he recieves
+			board_t my_pawns = board.pawns & (side == 0 ? board.white : board.black);
+			entry.king_square[side] = (uint8_t)king_square;
+			entry.shelter_score[side] = (int16_t)(20 * __popcnt64(get_king_mobility(side == 0) & my_pawns));
+		}
+
+		return entry;
 	}
 	int get_mobility_score(piece_t piece, bool endgame)
 	{
@@ -424,129 +358,139 @@ class Computer
 	}
 
 	// color: true - white, false - black
-	int get_mobility_evaluation(bool color, float endgame_weight)
+	// squares a piece attacks on a board with the given occupancy
+	board_t get_piece_attacks(piece_no_color_t piece, square_t square, board_t occupied)
 	{
-		bool turn_switch = board.white_to_move != color;
-		if (turn_switch)
-			board.no_move();
+		switch (piece)
+		{
+		case piece_no_color_t::knight:
+			return attacking_mask_knight[square];
+		case piece_no_color_t::bishop:
+			return bishop_attacks(square, occupied);
+		case piece_no_color_t::rook:
+			return rook_attacks(square, occupied);
+		case piece_no_color_t::queen:
+			return queen_attacks(square, occupied);
+		default:
+			return 0;
+		}
+	}
 
-		float eval = 0;
+	// https://www.chessprogramming.org/Mobility
+	// every square a piece attacks that isn't taken by a piece of its own color counts as a move,
+	// the attack sets come straight from the bitboards so pins and checks are ignored
+	// (pawns and the king are scored elsewhere)
+	int get_mobility_evaluation(bool color, float endgame_weight)
+	{
+		board_t occupied = board.white | board.black;
+		board_t color_mask = color ? board.white : board.black;
+		board_t targets = ~color_mask;
 		board_t oppponent_king_mobility = get_king_mobility(!color);
 
-		for (move_t chess_move : board.generate_moves())
-		{
-			piece_t moveing_piece = board.get_piece_type(board.get_move_from(chess_move));
-			square_t target_square = board.get_move_to(chess_move);
+		const piece_no_color_t pieces[] = { piece_no_color_t::knight, piece_no_color_t::bishop, piece_no_color_t::rook, piece_no_color_t::queen };
+		board_t piece_masks[] = { board.knights, board.bishops, board.rooks, board.queens };
 
-			// king mobility is calculated seperitly
-			if (moveing_piece == piece_t::black_king || moveing_piece == piece_t::white_king)
-				continue;
+		float mobility_weight = parameters.mobility_weight / 100.0f;
+		float king_attack_weight = parameters.king_attack_weight / 100.0f;
+
+		float eval = 0;
+		for (int i = 0; i < 4; i++)
+		{
+			int moves = 0;
+			int king_attacks = 0;
 
-			// if a piece attacks a square next to oppont king it could indicate attacking chances
-			// for this reson it is given extra points
-			if (oppponent_king_mobility & (1ull << target_square))
+			for (board_t b = piece_masks[i] & color_mask; b; b &= b - 1)
 			{
-				eval += get_king_attack_score(moveing_piece, false) * (1 - endgame_weight);
-				eval += get_king_attack_score(moveing_piece, true) * endgame_weight;
+				board_t attacks = get_piece_attacks(pieces[i], board.bit_pos(b), occupied) & targets;
+
+				moves += (int)__popcnt64(attacks);
+				// if a piece attacks a square next to oppont king it could indicate attacking chances
+				// for this reson it is given extra points
+				king_attacks += (int)__popcnt64(attacks & oppponent_king_mobility);
 			}
 
-			eval += get_mobility_score(moveing_piece, false) * (1 - endgame_weight);
-			eval += get_mobility_score(moveing_piece, true) * endgame_weight;
-		}
+			piece_t piece = (piece_t)((int)pieces[i] + (color ? 0 : 8));
 
-		if (turn_switch)
-			board.undo_move();
+			eval += moves * get_mobility_score(piece, false) * (1 - endgame_weight) * mobility_weight;
+			eval += moves * get_mobility_score(piece, true) * endgame_weight * mobility_weight;
+			eval += king_attacks * get_king_attack_score(piece, false) * (1 - endgame_weight) * king_attack_weight;
+			eval += king_attacks * get_king_attack_score(piece, true) * endgame_weight * king_attack_weight;
+		}
 
 		return eval;
 	}
 
-	int eval_open_file_positioning(bool color, float endgame_weight)
+	// pieces on files without pawns of their own color get a bonus (or a penalty), for pawns it means there is no other pawn on their file
+	int eval_open_file_positioning(bool color, float endgame_weight, const pawn_hash_entry& pawn_entry)
 	{
-		float eval = 0;
+		int side = color ? 0 : 1;
+		board_t color_mask = color ? board.white : board.black;
+		board_t semi_open_files = pawn_entry.semi_open_files[side];
 
-		board_t my_pawns = board.pawns & (color ? board.white : board.black);
-		for (square_t square = 0; square < 63; square++)
-		{
-			piece_t piece = board.get_piece_type(square);
-			if (piece == piece_t::empty)
-				continue;
+		const piece_no_color_t pieces[] = { piece_no_color_t::king, piece_no_color_t::pawn, piece_no_color_t::knight, piece_no_color_t::bishop, piece_no_color_t::rook, piece_no_color_t::queen };
+		board_t piece_masks[] = { board.kings, board.pawns, board.knights, board.bishops, board.rooks, board.queens };
 
-			if ((color ? board.black : board.white) & 1ull << square)
-				continue;
+		float eval = 0;
+		for (int i = 0; i < 6; i++)
+		{
+			int count = pieces[i] == piece_no_color_t::pawn ?
+				pawn_entry.lone_pawns[side] :
+				(int)__popcnt64(piece_masks[i] & color_mask & semi_open_files);
 
-			board_t file_mask = 0x0101010101010101ull << (square % 8);
-			board_t file_without_start_square = file_mask & ~(1ull << square);
-			bool is_semi_open = !(file_without_start_square & my_pawns);
-			eval += is_semi_open ? open_file_scores[(int)piece] * (1 - endgame_weight) : 0;
-			eval += is_semi_open ? open_file_scores[(int)piece + 15] * (endgame_weight) : 0;
+			int piece = (int)pieces[i] + (color ? 0 : 8);
+			eval += count * open_file_scores[piece] * (1 - endgame_weight);
+			eval += count * open_file_scores[piece + 15] * endgame_weight;
 		}
 
 		return (int)eval;
 	}
 
-	int calculate_king_safety(bool color, float endgame_weight)
+	int calculate_king_safety(bool color, float endgame_weight, const pawn_hash_entry& pawn_entry)
 	{
-		int eval = 0;
-		int dif;
-		square_t square = -1;
-		int my_king_mobility_sum = 0;
-
-		board_t my_king_mobility = get_king_mobility(color);
+		int eval = pawn_entry.shelter_score[color ? 0 : 1];
 
-		while (my_king_mobility)
-		{
-			dif = board.bit_pos(my_king_mobility);
-			my_king_mobility = my_king_mobility >> dif >> 1;
-			square += dif + 1;
-			my_king_mobility_sum += board.get_piece_type(square) == piece_t::empty ? 1 : 0;
-
-			// the more pawns there are in front of the king the more protection he recieves
-			if (color)
-				eval += board.get_piece_type(square) == piece_t::white_pawn ? 20 : 0;
-			else
-				eval += board.get_piece_type(square) == piece_t::black_pawn ? 20 : 0;
-		}
+		// free squares around the king
+		int my_king_mobility_sum = (int)__popcnt64(get_king_mobility(color) & ~(board.white | board.black));
 
 		eval += get_mobility_score(color ? piece_t::white_king : piece_t::black_king, false) * (1 - endgame_weight) * my_king_mobility_sum;
 		eval += get_mobility_score(color ? piece_t::white_king : piece_t::black_king, true) * endgame_weight * my_king_mobility_sum;
 
-		return eval;
+		return eval * parameters.king_safety_weight / 100;
 	}
 
 	int evaluate()
 	{
-		eval_count++;
-
-		board_state_t board_state;
-		board.get_board_state(board_state);
-		int eval = count_material();
+		stats.evaluations++;
 
 		// some parts of the evaluation can either be good or bad depending on the phaze of the game e.g. king activity
 		float white_endgame_weight = get_endgame_weight(count_endgame_material(true));
 		float black_endgame_weight = get_endgame_weight(count_endgame_material(false));
 		float endgame_weight = (white_endgame_weight + black_endgame_weight) / 2.0f;
 
+		// material and piece square tables are summed up by the board while the pieces move
+		// aprart of incentivising active play piece square tables also implicidly ealuate space and king safety
+		int eval = (int)(get_middlegame_score(board.piece_square_score) * (1 - endgame_weight) + get_endgame_score(board.piece_square_score) * endgame_weight);
+
 		eval += get_mobility_evaluation(true, endgame_weight);
 		eval -= get_mobility_evaluation(false, endgame_weight);
 
-		eval += evaluate_piece_square_tables(true, endgame_weight);
-		eval -= evaluate_piece_square_tables(false, endgame_weight);
+		pawn_hash_entry& pawn_entry = get_pawn_entry();
 
-		eval += eval_open_file_positioning(true, endgame_weight);
-		eval -= eval_open_file_positioning(false, endgame_weight);
+		eval += eval_open_file_positioning(true, endgame_weight, pawn_entry);
+		eval -= eval_open_file_positioning(false, endgame_weight, pawn_entry);
 
-		eval += calculate_king_safety(true, endgame_weight);
-		eval -= calculate_king_safety(false, endgame_weight);
+		eval += calculate_king_safety(true, endgame_weight, pawn_entry);
+		eval -= calculate_king_safety(false, endgame_weight, pawn_entry);
 
-		eval += evaluate_passed_pawns(true) * endgame_weight;
-		eval -= evaluate_passed_pawns(false) * endgame_weight;
+		eval += pawn_entry.passed_pawn_score[0] * endgame_weight;
+		eval -= pawn_entry.passed_pawn_score[1] * endgame_weight;
 
 		int tempo_eval = 15;
-		eval += board_state.get_turn() ?
+		eval += board.white_to_move ?
 			-tempo_eval * (1.0f - endgame_weight) :
 			tempo_eval * (1.0f - endgame_weight);
 
-		return board_state.get_turn() ? eval : -eval;
+		return board.white_to_move ? eval : -eval;
 	}
 
 
@@ -578,42 +522,54 @@ class Computer
 	}
 
 
-	void store_eval(board_state_t& board_state, int depth, int moves_played, int eval, node_type_t node_type, move_t chess_move)
+	// moves the mate evals from around check_mate_eval to around transposition_mate_eval so every eval fits in 16 bits
+	int pack_transposition_eval(int eval)
 	{
-		transposition_table_entry entry;
-		entry.depth = depth;
-		entry.eval = correct_mate_eval_storage(eval, moves_played);
-		entry.node_type = node_type;
-		entry.move = chess_move;
+		if (abs(eval) >= check_mate_eval - mate_eval_range)
+			return eval > 0 ? eval - check_mate_eval + transposition_mate_eval : eval + check_mate_eval - transposition_mate_eval;
 
-		transposition_table[board_state] = entry;
+		return clamp(eval, -transposition_mate_eval + mate_eval_range + 1, transposition_mate_eval - mate_eval_range - 1);
 	}
 
-	pair<int, int> lookup_eval(board_state_t& board_state, int depth, int moves_played, int alpha, int beta)
+	int unpack_transposition_eval(int eval)
 	{
-		auto iter = transposition_table.find(board_state);
-		if (iter == transposition_table.end())
+		if (abs(eval) >= transposition_mate_eval - mate_eval_range)
+			return eval > 0 ? eval - transposition_mate_eval + check_mate_eval : eval + transposition_mate_eval - check_mate_eval;
+
+		return eval;
+	}
+
+	void store_eval(uint64_t key, int depth, int moves_played, int eval, int static_eval, node_type_t node_type, move_t chess_move)
+	{
+		transposition_table->store(key, depth, pack_transposition_eval(correct_mate_eval_storage(eval, moves_played)), static_eval, node_type, board.get_short_move(chess_move));
+	}
+
+	// returns (0, eval) when the entry can be used instead of searching the position,
+	// (-1, 0) when the position isn't in the table (entry is nullptr) and (-2, 0) when the entry doesn't help
+	pair<int, int> lookup_eval(const transposition_table_entry* entry, int depth, int moves_played, int alpha, int beta)
+	{
+		if (entry == nullptr)
 			return make_pair(-1, 0);
 
-		transposition_table_entry entry = iter->second;
-		if (entry.depth >= depth)
+		if (entry->depth >= depth)
 		{
-			int eval = correct_mate_eval_retrive(entry.eval, moves_played);
+			int eval = correct_mate_eval_retrive(unpack_transposition_eval(entry->eval), moves_played);
+			node_type_t node_type = entry->node_type;
 
 			// due to the fact that we are useing alpha-beta pruning we can't just blindly trust in the past evaluation of the position
-			if (entry.node_type == node_type_t::exact)
+			if (node_type == node_type_t::exact)
 			{
-				transposition_count++;
+				stats.tt_cutoffs++;
 				return make_pair(0, eval);
 			}
-			if (entry.node_type == node_type_t::upper_bound && eval <= alpha)
+			if (node_type == node_type_t::upper_bound && eval <= alpha)
 			{
-				transposition_count++;
+				stats.tt_cutoffs++;
 				return make_pair(0, eval);
 			}
-			if (entry.node_type == node_type_t::lower_bound && eval >= beta)
+			if (node_type == node_type_t::lower_bound && eval >= beta)
 			{
-				transposition_count++;
+				stats.tt_cutoffs++;
 				return make_pair(0, eval);
 			}
 
@@ -621,53 +577,46 @@ class Computer
 		return make_pair(-2, 0);
 	}
 
-	move_t lookup_move(board_state_t& board_state)
+	// the static eval is taken from the transposition table entry if there is one, then from the eval cache and only then computed
+	int get_static_eval(uint64_t key, const transposition_table_entry* entry)
 	{
-		auto iter = transposition_table.find(board_state);
-		if (iter == transposition_table.end())
-			return board.encode_move(piece_no_color_t::empty, 0, 0);
-		return iter->second.move;
+		if (entry != nullptr && entry->static_eval != transposition_table_entry::no_static_eval)
+			return entry->static_eval;
+
+		int eval;
+		if (eval_cache->probe(key, eval))
+			return eval;
+
+		eval = evaluate();
+		eval_cache->store(key, eval);
+		return eval;
 	}
 
-	void order_moves(vector<move_t>& moves, int depth)
+	// the move saved for a position if it is legal there
+	move_t get_table_move(ChessBoard& position)
 	{
-		board_state_t board_state;
-		board.get_board_state(board_state);
-		vector<move_t> new_moves;
-		vector<long long> scores;
+		transposition_table_entry entry;
+		if (!transposition_table->probe(position.hash_key, entry))
+			return null_move;
 
-		move_t transposition_move = lookup_move(board_state);
+		move_t table_move = position.from_short_move(entry.move);
+		return position.is_move_legal(table_move) ? table_move : null_move;
+	}
 
-		for (move_t chess_move : moves)
+	// looks at the clock every time_check_interval nodes
+	bool is_search_stopped()
+	{
+		if ((stats.total_nodes() & (time_check_interval - 1)) == 0)
 		{
-			long long move_score = 0;
-			square_t target_square = board.get_move_to(chess_move);
-
-			piece_t move_piece_type = board_state.get_piece_type(board.get_move_from(chess_move));
-			piece_t capture_piece_type = board_state.get_piece_type(target_square);
-
-			if (chess_move == transposition_move)
-				move_score -= 5'000'000'000'000ll;
-
-			else if (capture_piece_type != piece_t::empty)
-			{
-				long long capture_material = 100'000'000ll * (long long)get_piece_value(capture_piece_type) - 1'000ll * (long long)get_piece_value(move_piece_type);
-				move_score -= capture_material;
-			}
-
-			else if (depth != -1 && chess_move == killers[depth])
-				move_score -= 1'000'000ll;
-			else
-				move_score -= quiet_history[chess_move % 4096];
-
-
-			auto iter = lower_bound(scores.begin(), scores.end(), move_score);
-			int index = distance(scores.begin(), iter);
-			new_moves.insert(new_moves.begin() + index, chess_move);
-			scores.insert(iter, move_score);
+			published_nodes.store(stats.total_nodes(), memory_order_relaxed);
+			if (time_manager.hard_limit_reached())
+				search_canceled = true;
 		}
 
-		moves = new_moves;
+		if (search_limits.nodes && stats.total_nodes() >= search_limits.nodes)
+			search_canceled = true;
+
+		return search_canceled;
 	}
 
 	// if the position analyzed by the eval funcion still has playable captures we cant trust the eval 
@@ -675,11 +624,19 @@ class Computer
 	// and only at the end the second search we evaluate the position
 	int search_captures(int moves_played, int alpha, int beta)
 	{
-		board_state_t board_state;
-		board.get_board_state(board_state);
+		stats.qnodes++;
+		if (is_search_stopped())
+			return 0;
+
+		uint64_t key = board.hash_key;
+
+		transposition_table_entry tt_entry;
+		const transposition_table_entry* tt_hit = transposition_table->probe(key, tt_entry) ? &tt_entry : nullptr;
+		stats.tt_probes++;
+		stats.tt_hits += tt_hit != nullptr;
 
 		// sometimes every capture is bad so we also have to consider doing nothing as a possibility too
-		int eval = evaluate();
+		int eval = get_static_eval(key, tt_hit);
 		int best_eval = eval;
 		if (eval >= beta)
 			return beta;
@@ -687,16 +644,21 @@ class Computer
 		alpha = max(alpha, eval);
 
 		// returns the evaluation if it has already been calculated
-		pair<int, int> transposition_table_eval = lookup_eval(board_state, 0, moves_played, alpha, beta);
+		pair<int, int> transposition_table_eval = lookup_eval(tt_hit, 0, moves_played, alpha, beta);
 		if (transposition_table_eval.first == 0)
 			return transposition_table_eval.second;
 
 		bool do_delta_pruning = count_endgame_material(true) + count_endgame_material(false) > 2;
 
-		vector<move_t> moves = board.generate_capture_moves();
-		order_moves(moves, -1);
+		move_t transposition_move = tt_hit ? board.from_short_move(tt_hit->move) : null_move;
+		MovePicker picker(board, transposition_move);
 
-		for (move_t chess_move : moves)
+		// the position is copied back after every move instead of undoing it
+		Position position;
+		board.get_position(position);
+
+		move_t chess_move;
+		while (picker.next(chess_move))
 		{
 			/*
 			https://www.chessprogramming.org/Delta_Pruning
@@ -708,9 +670,14 @@ class Computer
 			if (do_delta_pruning && eval < best_eval - capture_piece_value - 250)
 				break;
 
+			// a capture that loses material by the static exchange evaluation can't raise the eval above the stand pat
+			if (board.is_losing_capture(chess_move))
+				continue;
+
 			board.move(chess_move);
+			transposition_table->prefetch(board.hash_key);
 			int eval = -search_captures(moves_played, -beta, -alpha);
-			board.undo_move();
+			board.undo_move(position);
 
 			if (search_canceled)
 				return 0;
@@ -725,75 +692,466 @@ class Computer
 		return best_eval;
 	}
 
+	// helpers get the tables of the main search instead of allocating their own
+	Computer(shared_ptr<TranspositionTable> table, shared_ptr<EvalCache> cache)
+		: transposition_table(table), eval_cache(cache)
+	{
+		fill(begin(quiet_history), end(quiet_history), 0);
+	}
+
+	// resets everything that only lives for one search
+	void prepare_search()
+	{
+		for (int i = 0; i < 4096; i++)
+			quiet_history[i] /= 8;
+
+		for (int i = 0; i < max_depth; i++)
+			killers[i] = null_move;
+
+		search_canceled = false;
+
+		stats.start();
+		published_nodes.store(0, memory_order_relaxed);
+		pawn_hash_table.reset_counters();
+
+		repetitions.reset_search();
+
+		completed_depth = 0;
+	}
+
+	// the principal variation is read from the transposition table, it ends at a position that isn't in the table or repeats
+	vector<move_t> get_pv(move_t first_move, int max_length)
+	{
+		vector<move_t> pv = { first_move };
+
+		ChessBoard position = board;
+		position.move(first_move);
+		vector<uint64_t> keys = { board.hash_key, position.hash_key };
+
+		while ((int)pv.size() < max_length)
+		{
+			move_t next_move = get_table_move(position);
+			if (next_move == null_move)
+				break;
+
+			position.move(next_move);
+			if (find(keys.begin(), keys.end(), position.hash_key) != keys.end())
+				break;
+
+			keys.push_back(position.hash_key);
+			pv.push_back(next_move);
+		}
+
+		return pv;
+	}
+
+	// nodes of the running search on all threads, the helpers are counted up to their last published count
+	uint64_t searched_nodes()
+	{
+		uint64_t nodes = stats.total_nodes();
+		for (unique_ptr<Computer>& helper : helpers)
+			nodes += helper->published_nodes.load(memory_order_relaxed);
+		return nodes;
+	}
+
+	// called as soon as a line is finished
+	void print_line_info(int line)
+	{
+		const search_line_t& pv_line = pv_lines[line];
+
+		if (info_output == info_output_t::text)
+		{
+			if (multi_pv > 1)
+				cout << "line " << line + 1 << ", ";
+			cout << "depth: " << pv_line.depth << ", eval: " << pv_line.eval << " current best move: " << board.move_t_to_uci(pv_line.pv[0]);
+			cout << ", eval count: " << stats.evaluations << ", transposition count: " << stats.tt_cutoffs << '\n';
+		}
+		else if (info_output == info_output_t::uci)
+		{
+			uint64_t time = stats.elapsed().count();
+			uint64_t nodes = searched_nodes();
+			cout << "info depth " << pv_line.depth;
+			if (multi_pv > 1)
+				cout << " multipv " << line + 1;
+			cout << " score " << uci_score(pv_line.eval) << " nodes " << nodes;
+			cout << " nps " << (time ? nodes * 1000 / time : 0) << " time " << time;
+			cout << " hashfull " << transposition_table->hashfull() << " pv";
+			for (move_t chess_move : pv_line.pv)
+				cout << ' ' << board.move_t_to_uci(chess_move);
+			cout << endl;
+		}
+	}
+
+	// called when every line of a depth is finished
+	void print_depth_info(int depth)
+	{
+		stats.add_depth(depth, best_root_move.second);
+
+		if (info_output == info_output_t::json)
+			cout << SearchStats::depth_to_json(stats.depths.back()) << '\n';
+	}
+
+	bool next_root_move(uint32_t& index, move_t& chess_move)
+	{
+		if (index >= root_moves.size())
+			return false;
+
+		chess_move = root_moves[index++].chess_move;
+		return true;
+	}
+
+	// the root moves that weren't excluded by multipv from the best one, ties stay in the order they were searched in
+	void sort_root_moves()
+	{
+		stable_sort(root_moves.begin() + root_excluded_count, root_moves.end(),
+			[](const root_move_t& a, const root_move_t& b) { return a.eval > b.eval; });
+	}
+
+	// searches deeper and deeper until search_canceled is set or the time manager says to stop
+	// the helpers start on different depths so they don't all search the same tree at the same time
+	void iterative_deepening(int start_depth, bool print_info)
+	{
+		MoveList moves;
+		board.generate_moves(moves);
+
+		root_moves.clear();
+		for (move_t chess_move : moves)
+			root_moves.push_back({ chess_move, -check_mate_eval });
+
+		// a mated or stalemated root has nothing to search, the result is a null move with the mate or draw score
+		if (root_moves.empty())
+		{
+			best_root_move = make_pair(null_move, board.in_check() ? -check_mate_eval : 0);
+			pv_lines.clear();
+			return;
+		}
+
+		best_root_move = make_pair(root_moves[0].chess_move, 0);
+
+		// there can't be more lines than legal moves
+		int lines = min(multi_pv, (int)root_moves.size());
+		pv_lines.assign(lines, search_line_t());
+
+		for (int depth = start_depth; depth < max_depth; depth++)
+		{
+			if (search_limits.depth && depth > search_limits.depth)
+				return;
+
+			bool best_move_changed = false;
+			root_excluded_count = 0;
+			for (int line = 0; line < lines; line++)
+			{
+				// https://www.chessprogramming.org/Aspiration_Windows
+				// every line has its own window around its eval from the previous depth
+				int eval = pv_lines[line].eval;
+				int window = 40;
+				while (true)
+				{
+					int alpha = eval - window;
+					int	beta = eval + window;
+
+					eval = search(depth, 0, alpha, beta, true);
+
+					if (search_canceled)
+						return;
+
+					sort_root_moves();
+
+					if (alpha < eval && eval < beta)
+						break;
+					window *= 2;
+				}
+
+				move_t line_move = root_moves[root_excluded_count].chess_move;
+				if (line == 0)
+				{
+					best_move_changed = depth > start_depth && line_move != best_root_move.first;
+					best_root_move = make_pair(line_move, eval);
+				}
+
+				pv_lines[line] = { get_pv(line_move, depth), eval, depth };
+				root_excluded_count++;
+
+				if (print_info)
+					print_line_info(line);
+			}
+
+			completed_depth = depth;
+			if (print_info)
+				print_depth_info(depth);
+
+			if (time_manager.soft_limit_reached(best_move_changed))
+				return;
+		}
+	}
+
 public:
 	Computer()
+		: Computer(make_shared<TranspositionTable>(default_hash_size_mb), make_shared<EvalCache>(default_eval_cache_size_mb))
 	{
-		board_history = {};
-		transposition_table.clear();
+	}
 
-		mirror_array(&pawns_early_square_table_white[0], &pawns_early_square_table_black[0]);
-		mirror_array(&pawns_end_square_table_white[0], &pawns_end_square_table_black[0]);
-		mirror_array(&knights_square_table_white[0], &knights_square_table_black[0]);
-		mirror_array(&bishops_square_table_white[0], &bishops_square_table_black[0]);
-		mirror_array(&rooks_square_table_white[0], &rooks_square_table_black[0]);
-		mirror_array(&queens_square_table_white[0], &queens_square_table_black[0]);
-		mirror_array(&king_early_square_table_white[0], &king_early_square_table_black[0]);
-		mirror_array(&king_end_square_table_white[0], &king_end_square_table_black[0]);
+	~Computer()
+	{
+		stop_ponder();
+	}
 
-		for (int i = 0; i < 64; i++)
+	// evaluations of the main search and all the helpers
+	int get_eval_count()
+	{
+		return (int)get_search_stats().evaluations;
+	}
+
+	// counters of the last search summed over all threads, the depths are the ones finished by the main search
+	SearchStats get_search_stats()
+	{
+		SearchStats total = stats;
+		for (unique_ptr<Computer>& helper : helpers)
+			total.add(helper->stats);
+		return total;
+	}
+
+	void set_info_output(info_output_t output)
+	{
+		info_output = output;
+	}
+
+	// amount of best moves searched (with their own principal variations), 1 is the normal search
+	void set_multi_pv(int lines)
+	{
+		multi_pv = max(1, lines);
+	}
+
+	// lines of the last search of the main thread in the order they were found, the first one is the best move
+	vector<search_line_t> get_pv_lines()
+	{
+		return pv_lines;
+	}
+
+	// mates are reported in moves (negative when the side to move gets mated)
+	string uci_score(int eval)
+	{
+		if (abs(eval) < check_mate_eval - mate_eval_range)
+			return "cp " + to_string(eval);
+
+		int plies = check_mate_eval - abs(eval);
+		int moves = (plies + 1) / 2;
+		return "mate " + to_string(eval > 0 ? moves : -moves);
+	}
+
+	// the search uses the calling thread and count - 1 helper threads
+	void set_threads(int count)
+	{
+		helpers.clear();
+		for (int i = 1; i < count; i++)
 		{
-			white_passed_pawn_masks[i] = generate_passed_pawn_mask(i, true);
-			black_passed_pawn_masks[i] = generate_passed_pawn_mask(i, false);
-			white_king_attack_mask[i] = generate_king_attack_mask(i, true);
-			black_king_attack_mask[i] = generate_king_attack_mask(i, false);
+			helpers.push_back(unique_ptr<Computer>(new Computer(transposition_table, eval_cache)));
+			helpers.back()->pawn_hash_table.resize(pawn_hash_table.size_mb());
+			helpers.back()->parameters = parameters;
 		}
 	}
 
-	int get_eval_count()
+	// the helpers search with the same parameters, the cached evals were calculated with the old ones so they are forgotten
+	void set_parameters(const search_parameters_t& new_parameters)
+	{
+		parameters = new_parameters;
+		for (unique_ptr<Computer>& helper : helpers)
+			helper->parameters = new_parameters;
+
+		eval_cache->resize(eval_cache->size_mb());
+		transposition_table->clear();
+	}
+
+	search_parameters_t get_parameters()
+	{
+		return parameters;
+	}
+
+	int get_threads()
+	{
+		return (int)helpers.size() + 1;
+	}
+
+	void set_hash_size(size_t size_mb)
+	{
+		transposition_table->resize(size_mb);
+	}
+
+	void set_eval_cache_size(size_t size_mb)
 	{
-		return eval_count;
+		eval_cache->resize(size_mb);
+	}
+
+	// every thread has a pawn hash table of this size
+	void set_pawn_hash_size(size_t size_mb)
+	{
+		pawn_hash_table.resize(size_mb);
+		for (unique_ptr<Computer>& helper : helpers)
+			helper->pawn_hash_table.resize(size_mb);
+	}
+
+	// percentage of evaluations that found their pawn structure in the pawn hash table during the last search (main thread)
+	double get_pawn_hash_hit_rate()
+	{
+		return pawn_hash_table.hit_rate();
 	}
 
 	void set_board(ChessBoard new_board)
 	{
 		board = new_board;
-		board_history = {};
-		transposition_table.clear();
+		repetitions.clear();
+		transposition_table->clear();
 	}
 
 	void play_move_on_board(move_t chess_move)
 	{
-		board_state_t board_state;
-		board.get_board_state(board_state);
-		board_history.push_back(board_state);
+		repetitions.add_game_position(board.hash_key);
 		board.move(chess_move);
 	}
 
-	int search(int depth, int moves_played, int alpha, int beta, bool null_move_allowed = true)
+	// sets the position as a start position and the moves played from it, unlike set_board the transposition table is kept
+	void set_game(ChessBoard start, const vector<move_t>& moves)
 	{
-		board_state_t board_state;
-		board.get_board_state(board_state);
+		board = start;
+		repetitions.clear();
 
-		bool do_pruning = alpha == beta - 1 && !board.in_check();
-		int best_eval = -check_mate_eval;
-		int eval = evaluate();
+		for (move_t chess_move : moves)
+			play_move_on_board(chess_move);
+	}
+
+	// forgets everything learned in the previous game
+	void new_game()
+	{
+		transposition_table->clear();
+		fill(begin(quiet_history), end(quiet_history), 0);
+		for (unique_ptr<Computer>& helper : helpers)
+			fill(begin(helper->quiet_history), end(helper->quiet_history), 0);
+	}
+
+	// can be called from a different thread than the one running the search
+	void stop()
+	{
+		search_canceled = true;
+	}
+
+	// a pondering search started with limits.ponder set uses its limits from now on
+	void ponder_hit()
+	{
+		time_manager.ponder_hit();
+	}
+
+	// the reply expected after best_move (the second move of the principal variation), null_move when the table doesn't know it
+	move_t get_ponder_move(move_t best_move)
+	{
+		ChessBoard next = board;
+		next.move(best_move);
+		return get_table_move(next);
+	}
+
+	// called after the computer's move was played on the board, searches the expected reply in the background
+	// limits are the ones of the computer's next move, they start to apply on a ponder hit
+	bool start_ponder(search_limits_t limits)
+	{
+		stop_ponder();
+
+		ponder_move = get_table_move(board);
+		if (ponder_move == null_move)
+			return false;
+
+		board_before_ponder = board;
+		repetitions_before_ponder = repetitions;
+		play_move_on_board(ponder_move);
 
-		// checks for 3 move repetition
-		if (count(board_history.begin(), board_history.end(), board_state) >= 3)
+		limits.ponder = true;
+		start_search(limits);
+		ponder_thread = thread([this]() { ponder_result = run_search(); });
+		return true;
+	}
+
+	bool is_pondering()
+	{
+		return ponder_thread.joinable();
+	}
+
+	// called with the move the opponent actually played
+	// on a ponder hit the search goes on until its limits (the time spent pondering counts as used) and its result is returned,
+	// on a miss the search is stopped, the board goes back to the position before the expected reply and false is returned
+	// the transposition table keeps everything found while pondering in both cases
+	bool finish_ponder(move_t opponent_move, pair<move_t, int>& result)
+	{
+		if (!is_pondering())
+			return false;
+
+		if (opponent_move != ponder_move)
+		{
+			stop_ponder();
+			return false;
+		}
+
+		ponder_hit();
+		ponder_thread.join();
+		result = ponder_result;
+		return true;
+	}
+
+	void stop_ponder()
+	{
+		if (!is_pondering())
+			return;
+
+		stop();
+		ponder_thread.join();
+
+		board = board_before_ponder;
+		repetitions = repetitions_before_ponder;
+	}
+
+	// with a knight, bishop, rook or queen on the board the side to move is assumed to have a move (only a pin of every one of them could stop it),
+	// so the move generation only runs in king and pawn positions where a stalemate really happens
+	bool has_legal_moves()
+	{
+		board_t color_mask = board.white_to_move ? board.white : board.black;
+		if ((board.knights | board.bishops | board.rooks | board.queens) & color_mask)
+			return true;
+
+		MoveList moves;
+		board.generate_moves(moves);
+		return !moves.empty();
+	}
+
+	int search(int depth, int moves_played, int alpha, int beta, bool null_move_allowed = true)
+	{
+		stats.nodes++;
+		if (is_search_stopped())
 			return 0;
 
-		// we dont need to check until 3 move repetition 
+		uint64_t key = board.hash_key;
+
+		bool in_check = board.in_check();
+		bool do_pruning = alpha == beta - 1 && !in_check;
+		int best_eval = -check_mate_eval;
+		// the root result of a multipv line other than the first one isn't the result of the whole position
+		bool store_result = moves_played > 0 || root_excluded_count == 0;
+
+		// we dont need to check until 3 move repetition inside of the search
 		// if repeting the position once turns out to be the best we can safely assume that 
 		// repeting moves is the best aproach
-		if (find(board_history_search.begin(), board_history_search.end(), board_state) != board_history_search.end() && null_move_allowed)
+		// the root is never scored as a draw so there is always a move to play
+		if (moves_played > 0 && repetitions.is_repetition(key, board.last_pawn_move))
 			return 0;
 
-		if (board.in_check())
+		if (in_check)
 			depth++;
 
+		transposition_table_entry tt_entry;
+		const transposition_table_entry* tt_hit = transposition_table->probe(key, tt_entry) ? &tt_entry : nullptr;
+		stats.tt_probes++;
+		stats.tt_hits += tt_hit != nullptr;
+
 		// returns the evaluation if it has already been calculated
-		pair<int, int> transposition_table_eval = lookup_eval(board_state, depth, moves_played, alpha, beta);
-		if (transposition_table_eval.first == 0)
+		// the root always searches its moves so the best move is known (and the moves excluded by multipv are skipped)
+		pair<int, int> transposition_table_eval = lookup_eval(tt_hit, depth, moves_played, alpha, beta);
+		if (transposition_table_eval.first == 0 && moves_played > 0)
 			return transposition_table_eval.second;
 
 		//Internal Iterative Reductions
@@ -804,45 +1162,55 @@ public:
 		if (depth <= 0)
 			return search_captures(moves_played, alpha, beta);
 
-		vector<move_t> moves = board.generate_moves();
+		// the static eval is only needed by the pruning, a position in check is never evaluated
+		int static_eval = in_check ? transposition_table_entry::no_static_eval : get_static_eval(key, tt_hit);
+		int eval = static_eval;
 
-		// checks for checkmate and stalemate
-		if (moves.size() == 0)
+		// Reverse futility pruning
+		// a stalemate is only found after the move loop, so the pruning that returns before it has to rule it out (only when it would prune)
+		if (do_pruning && depth <= parameters.rfp_max_depth && eval > beta + depth * parameters.rfp_margin && has_legal_moves())
 		{
-			if (board.in_check())
-				return -check_mate_eval + moves_played;
-			return 0;
+			stats.rfp_prunes++;
+			return eval;
 		}
 
-		// Reverse futility pruning
-		if (do_pruning && depth < 7 && eval > beta + depth * RFP_margin)
-			return eval;
+		Position position;
+		board.get_position(position);
 
 		// null move pruning
-		if (do_pruning && null_move_allowed && eval >= beta && depth > 2 && count_endgame_material(true) + count_endgame_material(false) >= null_move_pruning_cutof)
+		if (do_pruning && null_move_allowed && eval >= beta && depth >= parameters.null_move_min_depth && count_endgame_material(true) + count_endgame_material(false) >= parameters.null_move_min_material)
 		{
 			board.no_move();
-			eval = -search(depth - 4, moves_played + 1, -beta, -alpha, false);
-			board.undo_move();
+			eval = -search(depth - parameters.null_move_reduction, moves_played + 1, -beta, -alpha, false);
+			board.undo_move(position);
 
-			if (eval >= beta)
+			if (eval >= beta && has_legal_moves())
+			{
+				stats.null_move_prunes++;
 				return beta;
+			}
 		}
 
-		order_moves(moves, depth);
+		move_t transposition_move = tt_hit ? board.from_short_move(tt_hit->move) : null_move;
+		MovePicker picker(board, transposition_move, killers[moves_played], quiet_history);
+		// the root list is only filled by iterative_deepening, a search called on its own uses the picker at the root too
+		bool use_root_moves = moves_played == 0 && !root_moves.empty();
+		uint32_t root_index = root_excluded_count;
 
 		node_type_t current_eval_type = node_type_t::upper_bound;
 		move_t best_move = null_move;
 		int moves_searched = 0;
 		int quiet_moves_evaluated = 0;
-		vector<move_t> quiets_evaluated;
-		for (move_t chess_move : moves)
+		MoveList quiets_evaluated;
+		move_t chess_move;
+		while (use_root_moves ? next_root_move(root_index, chess_move) : picker.next(chess_move))
 		{
 			bool is_capture = board.get_piece_type(board.get_move_to(chess_move)) != piece_t::empty;
 			bool is_promotion = board.get_promotion(chess_move) != piece_t::empty;
 
 			board.move(chess_move);
-			board_history_search.push_back(board_state);
+			transposition_table->prefetch(board.hash_key);
+			repetitions.push(key);
 
 			bool is_quiet = !(is_capture || is_promotion);
 			bool succes = false;
@@ -853,10 +1221,13 @@ public:
 			its likely bad for this reson we run it on a shalower depth
 			and with a null window wich means we are only looking if a move is better not how much
 			*/
-			if (depth > 2 && moves_searched > 4 && is_quiet && moves_searched != 0)
+			if (depth >= parameters.lmr_min_depth && moves_searched >= parameters.lmr_min_moves && is_quiet && moves_searched != 0)
 			{
-				eval = -search(depth - 2, moves_played + 1, -alpha - 1, -alpha, true);
+				eval = -search(depth - 1 - parameters.lmr_reduction, moves_played + 1, -alpha - 1, -alpha, true);
 				succes = eval <= alpha;
+
+				stats.lmr_searches++;
+				stats.lmr_researches += !succes;
 			}
 
 			if (!succes && moves_searched != 0)
@@ -868,14 +1239,18 @@ public:
 			if (!succes)
 				eval = -search(depth - 1, moves_played + 1, -beta, -alpha, true);
 
-			board_history_search.pop_back();
-			board.undo_move();
+			repetitions.pop();
+			board.undo_move(position);
 
 			moves_searched++;
 
 			if (search_canceled)
 				return best_eval;
 
+			// only the first move and the moves that raised alpha have a real eval, the others keep their order from before behind them
+			if (use_root_moves)
+				root_moves[root_index - 1].eval = moves_searched == 1 || eval > alpha ? eval : -check_mate_eval;
+
 			if (eval > best_eval)
 			{
 				best_move = chess_move;
@@ -884,6 +1259,9 @@ public:
 
 			if (eval >= beta)
 			{
+				stats.fail_highs++;
+				stats.fail_highs_first += moves_searched == 1;
+
 				if (is_quiet)
 				{
 					// sience all positions we are analyzeing are more or less the same
@@ -895,7 +1273,8 @@ public:
 					killers[moves_played] = chess_move;
 				}
 
-				store_eval(board_state, depth, moves_played, beta, node_type_t::lower_bound, chess_move);
+				if (store_result)
+					store_eval(key, depth, moves_played, beta, static_eval, node_type_t::lower_bound, chess_move);
 				return beta;
 			}
 			if (eval > alpha)
@@ -918,7 +1297,16 @@ public:
 				break;
 		}
 
-		store_eval(board_state, depth, moves_played, best_eval, current_eval_type, best_move);
+		// checks for checkmate and stalemate
+		if (moves_searched == 0)
+		{
+			if (board.in_check())
+				return -check_mate_eval + moves_played;
+			return 0;
+		}
+
+		if (store_result)
+			store_eval(key, depth, moves_played, best_eval, static_eval, current_eval_type, best_move);
 		return best_eval;
 	}
 	// 1ms - 1440 elo
@@ -928,58 +1316,68 @@ public:
 	// 5000ms - 2060 elo
 	pair<move_t, int> deapening_search(chrono::milliseconds time)
 	{
-		for (int i = 0; i < 4096; i++)
-			quiet_history[i] /= 8;
+		search_limits_t limits;
+		limits.move_time = time;
+		return deapening_search(limits);
+	}
 
-		for (int i = 0; i < max_depth; i++)
-			killers[i] = null_move;
+	// a search still pondering is treated as a ponder miss
+	pair<move_t, int> deapening_search(const search_limits_t& limits)
+	{
+		stop_ponder();
+		start_search(limits);
+		return run_search();
+	}
 
-		search_canceled = false;
+	// resets everything for a new search, done before the search threads are started
+	// so a search running on a different thread can be stopped right after it is started
+	void start_search(const search_limits_t& limits)
+	{
+		transposition_table->new_search();
+		prepare_search();
+		search_limits = limits;
+		time_manager.start(limits);
+	}
 
-		thread t1([&]()
-			{
-				this_thread::sleep_for(time);
-				search_canceled = true;
-			});
+	// runs the search set up by start_search on the calling thread and the helper threads
+	pair<move_t, int> run_search()
+	{
+		vector<thread> helper_threads;
+		for (size_t i = 0; i < helpers.size(); i++)
+		{
+			Computer* helper = helpers[i].get();
+			helper->board = board;
+			helper->repetitions = repetitions;
+			helper->prepare_search();
 
-		t1.detach();
+			helper_threads.emplace_back([helper, i]() { helper->iterative_deepening(1 + (i + 1) % 2, false); });
+		}
 
-		eval_count = 0;
-		transposition_count = 0;
+		iterative_deepening(1, true);
 
-		board_history_search = {};
+		for (unique_ptr<Computer>& helper : helpers)
+			helper->search_canceled = true;
 
-		pair<move_t, int> best_move = make_pair(board.generate_moves()[0], 0);
+		for (thread& t : helper_threads)
+			t.join();
 
-		board_state_t board_state;
-		board.get_board_state(board_state);
+		root_moves.clear();
 
-		int eval = 0;
-		for (int depth = 1; depth < max_depth; depth++)
+		// the result of the thread that got the deepest is used
+		pair<move_t, int> best_move = best_root_move;
+		int best_depth = completed_depth;
+		for (unique_ptr<Computer>& helper : helpers)
 		{
-			// https://www.chessprogramming.org/Aspiration_Windows
-			int window = 40;
-			while (true)
+			if (helper->completed_depth > best_depth)
 			{
-				int alpha = eval - window;
-				int	beta = eval + window;
-
-				eval = search(depth, 0, alpha, beta, true);
-				move_t new_best_move = lookup_move(board_state);
-
-				if (search_canceled)
-					return best_move;
-
-				if (alpha < eval && eval < beta)
-				{
-					best_move = make_pair(new_best_move, eval);
-
-					cout << "depth: " << depth << ", eval: " << best_move.second << " current best move: " << board.move_t_to_uci(best_move.first);
-					cout << ", eval count: " << eval_count << ", transposition count: " << transposition_count << '\n';
-					break;
-				}
-				window *= 2;
+				best_depth = helper->completed_depth;
+				best_move = helper->best_root_move;
 			}
 		}
+
+		if (info_output == info_output_t::json)
+			cout << get_search_stats().to_json() << '\n';
+
+		return best_move;
 	}
 };
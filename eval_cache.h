@@ -0,0 +1,64 @@
+#pragma once
+
+#include <cstdint>
+#include <vector>
+#include <atomic>
+#include <algorithm>
+#include <bit>
+
+using namespace std;
+
+/*
+https://www.chessprogramming.org/Evaluation_Hash_Table
+static evals of recently evaluated positions, so a position reached again (through a transposition or by the next iteration) isn't evaluated twice.
+an entry is a single 64 bit word with the upper 48 bits of the key and a 16 bit eval, reading or writing it is one atomic operation
+so the table is shared by all search threads without any locks
+*/
+class EvalCache
+{
+	static constexpr uint64_t eval_mask = 0xffffull;
+
+	vector<atomic<uint64_t>> entries;
+	uint64_t index_mask = 0;
+
+public:
+	EvalCache(size_t size_mb)
+	{
+		resize(size_mb);
+	}
+
+	// the amount of entries is rounded down to a power of 2 so the index is just a mask
+	// must not be called while a search is running
+	void resize(size_t size_mb)
+	{
+		size_t count = bit_floor(max<size_t>(1, size_mb * 1024 * 1024 / sizeof(uint64_t)));
+
+		entries = vector<atomic<uint64_t>>(count);
+		index_mask = count - 1;
+	}
+
+	size_t size_mb() const
+	{
+		return entries.size() * sizeof(uint64_t) / (1024 * 1024);
+	}
+
+	// returns false if the position isn't in the cache
+	bool probe(uint64_t key, int& eval)
+	{
+		uint64_t entry = entries[key & index_mask].load(memory_order_relaxed);
+		if ((entry & ~eval_mask) != (key & ~eval_mask))
+			return false;
+
+		eval = (int16_t)(entry & eval_mask);
+		return true;
+	}
+
+	// evals that don't fit in 16 bits aren't saved
+	void store(uint64_t key, int eval)
+	{
+		if (eval < INT16_MIN || eval > INT16_MAX)
+			return;
+
+		entries[key & index_mask].store((key & ~eval_mask) | (uint16_t)eval, memory_order_relaxed);
+	}
+};
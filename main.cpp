@@ -492,34 +492,36 @@ int draw_board(std::atomic<char>* fen)
 			for (int y = 0; y < 8; y++) { // Loop through each row of the chessboard
 
 				// Check the type of piece at the current position
+				piece_t piece = board.get_piece_type(x + (y * 8));
+
 				// If the square is empty, skip rendering
-				if (board.get_piece_type(x + (y * 8)) == piece_t::empty)
+				if (piece == piece_t::empty)
 					continue;
 
 				// Bind the appropriate texture based on the type of piece
-				else if (board.get_piece_type(x + (y * 8)) == piece_t::black_bishop)
+				else if (piece == piece_t::black_bishop)
 					glBindTexture(GL_TEXTURE_2D, texturebB); // Bind black bishop texture
-				else if (board.get_piece_type(x + (y * 8)) == piece_t::black_king)
+				else if (piece == piece_t::black_king)
 					glBindTexture(GL_TEXTURE_2D, texturebK); // Bind black king texture
-				else if (board.get_piece_type(x + (y * 8)) == piece_t::black_knight)
+				else if (piece == piece_t::black_knight)
 					glBindTexture(GL_TEXTURE_2D, texturebN); // Bind black knight texture
-				else if (board.get_piece_type(x + (y * 8)) == piece_t::black_pawn)
+				else if (piece == piece_t::black_pawn)
 					glBindTexture(GL_TEXTURE_2D, texturebp); // Bind black pawn texture
-				else if (board.get_piece_type(x + (y * 8)) == piece_t::black_queen)
+				else if (piece == piece_t::black_queen)
 					glBindTexture(GL_TEXTURE_2D, texturebQ); // Bind black queen texture
-				else if (board.get_piece_type(x + (y * 8)) == piece_t::black_rook)
+				else if (piece == piece_t::black_rook)
 					glBindTexture(GL_TEXTURE_2D, texturebR); // Bind black rook texture
-				else if (board.get_piece_type(x + (y * 8)) == piece_t::white_bishop)
+				else if (piece == piece_t::white_bishop)
 					glBindTexture(GL_TEXTURE_2D, texturewB); // Bind white bishop texture
-				else if (board.get_piece_type(x + (y * 8)) == piece_t::white_king)
+				else if (piece == piece_t::white_king)
 					glBindTexture(GL_TEXTURE_2D, texturewK); // Bind white king texture
-				else if (board.get_piece_type(x + (y * 8)) == piece_t::white_knight)
+				else if (piece == piece_t::white_knight)
 					glBindTexture(GL_TEXTURE_2D, texturewN); // Bind white knight texture
-				else if (board.get_piece_type(x + (y * 8)) == piece_t::white_pawn)
+				else if (piece == piece_t::white_pawn)
 					glBindTexture(GL_TEXTURE_2D, texturewp); // Bind white pawn texture
-				else if (board.get_piece_type(x + (y * 8)) == piece_t::white_queen)
+				else if (piece == piece_t::white_queen)
 					glBindTexture(GL_TEXTURE_2D, texturewQ); // Bind white queen texture
-				else if (board.get_piece_type(x + (y * 8)) == piece_t::white_rook)
+				else if (piece == piece_t::white_rook)
 					glBindTexture(GL_TEXTURE_2D, texturewR); // Bind white rook texture
 
 				// Generate a Vertex Array Object (VAO) for the current piece position
@@ -680,15 +682,25 @@ void playBot(atomic<char>* fen) {
 				return; // Exit the game
 			}
 
-			// Bot plays the player's move on its internal representation of the board
-			computer.play_move_on_board(move_);
+			// If the bot was pondering on the player's move it keeps that search, otherwise it starts a new one
+			pair<move_t, int> output;
+			if (!computer.finish_ponder(move_, output))
+			{
+				// Bot plays the player's move on its internal representation of the board
+				computer.play_move_on_board(move_);
 
-			// Perform bot search for the best move using deepening search with a time constraint
-			pair<move_t, int> output = computer.deapening_search(chrono::milliseconds(C)); // C is the difficulty level/time limit
+				// Perform bot search for the best move using deepening search with a time constraint
+				output = computer.deapening_search(chrono::milliseconds(C)); // C is the difficulty level/time limit
+			}
 
 			// Bot applies the chosen move to its internal board representation
 			computer.play_move_on_board(output.first);
 
+			// Bot thinks about the player's expected reply while the player is thinking
+			search_limits_t ponder_limits;
+			ponder_limits.move_time = chrono::milliseconds(C);
+			computer.start_ponder(ponder_limits);
+
 			// Display evaluation score of the bot's chosen move
 			cout << "eval: " << output.second << endl;
 
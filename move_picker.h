@@ -0,0 +1,203 @@
+#pragma once
+
+#include "board.h"
+
+using namespace std;
+
+enum class pick_stage_t
+{
+	tt_move = 0,
+	generate_captures = 1,
+	captures = 2,
+	killer = 3,
+	generate_quiets = 4,
+	quiets = 5,
+	bad_captures = 6,
+	done = 7,
+};
+
+// piece values used to order the captures, indexed by piece_no_color_t
+inline constexpr int mvv_lva_values[7] = { 0, 0, 100, 300, 325, 500, 900 };
+
+// https://www.chessprogramming.org/MVV-LVA
+// scores of every (victim, attacker) pair, the victim decides first and the cheaper attacker breaks the ties
+// en-passant is the only capture where the target square is empty so the empty row scores like a pawn
+struct mvv_lva_table_t
+{
+	int scores[7][7] = {};
+};
+
+constexpr mvv_lva_table_t generate_mvv_lva_table()
+{
+	mvv_lva_table_t table;
+
+	for (int victim = 0; victim < 7; victim++)
+	{
+		int victim_value = victim == (int)piece_no_color_t::empty ? mvv_lva_values[(int)piece_no_color_t::pawn] : mvv_lva_values[victim];
+		for (int attacker = 0; attacker < 7; attacker++)
+			table.scores[victim][attacker] = 1'000 * victim_value - mvv_lva_values[attacker];
+	}
+
+	return table;
+}
+
+inline constexpr mvv_lva_table_t mvv_lva_table = generate_mvv_lva_table();
+
+/*
+https://www.chessprogramming.org/Move_Generation#Staged_Move_Generation
+hands out the moves of a position one by one, the best looking ones first.
+a stage is only generated when the previous one is used up, so when the transposition move or a capture
+causes a beta cutoff the quiet moves are never generated or sorted
+order: transposition move, winning and equal captures (most valuable victim - least valuable attacker), killer move, quiet moves sorted by history, losing captures
+the capture search only needs the first two stages and checks the exchanges itself
+*/
+class MovePicker
+{
+	ChessBoard& board;
+	move_t tt_move;
+	move_t killer = 0;
+	const long* quiet_history = nullptr;
+	bool captures_only = false;
+
+	pick_stage_t stage = pick_stage_t::tt_move;
+	MoveList moves;
+	// captures that lose material by the static exchange evaluation, they are tried after the quiet moves
+	MoveList bad_captures;
+	long long scores[MoveList::capacity];
+	uint32_t current = 0;
+
+	void score_captures()
+	{
+		for (uint32_t i = 0; i < moves.count; i++)
+		{
+			move_t chess_move = moves[i];
+			int victim = (int)board.get_piece_type(board.get_move_to(chess_move)) % 8;
+			int attacker = (int)board.get_piece_type(board.get_move_from(chess_move)) % 8;
+			int promotion_value = mvv_lva_values[(int)board.get_promotion(chess_move) % 8];
+
+			scores[i] = mvv_lva_table.scores[victim][attacker] + 1'000ll * promotion_value;
+		}
+	}
+
+	void score_quiets()
+	{
+		for (uint32_t i = 0; i < moves.count; i++)
+			scores[i] = quiet_history[moves[i] % 4096];
+	}
+
+	// selection sort step, only the moves that are actually searched get sorted
+	move_t pick_best()
+	{
+		uint32_t best = current;
+		for (uint32_t i = current + 1; i < moves.count; i++)
+			if (scores[i] > scores[best])
+				best = i;
+
+		swap(moves[current], moves[best]);
+		swap(scores[current], scores[best]);
+
+		return moves[current++];
+	}
+
+public:
+	MovePicker(ChessBoard& board, move_t tt_move, move_t killer, const long* quiet_history)
+		: board(board), tt_move(tt_move), killer(killer), quiet_history(quiet_history)
+	{
+	}
+
+	// only hands out captures, used by the capture search
+	MovePicker(ChessBoard& board, move_t tt_move)
+		: board(board), tt_move(tt_move), captures_only(true)
+	{
+	}
+
+	// returns false when there are no more moves
+	bool next(move_t& chess_move)
+	{
+		switch (stage)
+		{
+		case pick_stage_t::tt_move:
+			stage = pick_stage_t::generate_captures;
+
+			// the transposition move could come from a different position with the same hash
+			if ((!captures_only || board.is_capture(tt_move)) && board.is_move_legal(tt_move))
+			{
+				chess_move = tt_move;
+				return true;
+			}
+			[[fallthrough]];
+
+		case pick_stage_t::generate_captures:
+			board.generate_capture_moves(moves);
+			score_captures();
+			current = 0;
+			stage = pick_stage_t::captures;
+			[[fallthrough]];
+
+		case pick_stage_t::captures:
+			while (current < moves.count)
+			{
+				chess_move = pick_best();
+				if (chess_move == tt_move)
+					continue;
+
+				if (!captures_only && board.is_losing_capture(chess_move))
+				{
+					bad_captures.push_back(chess_move);
+					continue;
+				}
+
+				return true;
+			}
+			if (captures_only)
+			{
+				stage = pick_stage_t::done;
+				break;
+			}
+			stage = pick_stage_t::killer;
+			[[fallthrough]];
+
+		case pick_stage_t::killer:
+			stage = pick_stage_t::generate_quiets;
+
+			if (killer != tt_move && !board.is_capture(killer) && board.is_move_legal(killer))
+			{
+				chess_move = killer;
+				return true;
+			}
+			[[fallthrough]];
+
+		case pick_stage_t::generate_quiets:
+			board.generate_quiet_moves(moves);
+			score_quiets();
+			current = 0;
+			stage = pick_stage_t::quiets;
+			[[fallthrough]];
+
+		case pick_stage_t::quiets:
+			while (current < moves.count)
+			{
+				chess_move = pick_best();
+				if (chess_move != tt_move && chess_move != killer)
+					return true;
+			}
+			current = 0;
+			stage = pick_stage_t::bad_captures;
+			[[fallthrough]];
+
+		case pick_stage_t::bad_captures:
+			if (current < bad_captures.count)
+			{
+				chess_move = bad_captures[current++];
+				return true;
+			}
+			stage = pick_stage_t::done;
+			[[fallthrough]];
+
+		case pick_stage_t::done:
+			break;
+		}
+
+		return false;
+	}
+};
@@ -0,0 +1,91 @@
+#pragma once
+
+#include <cstdint>
+#include <vector>
+#include <algorithm>
+#include <bit>
+
+#include "board.h"
+
+using namespace std;
+
+// everything the evaluation needs that only depends on where the pawns are
+// indexes: 0 - white, 1 - black
+struct pawn_hash_entry
+{
+	uint64_t key;
+
+	board_t passed_pawns[2];
+	// every file without a pawn of that color, as a bitboard of whole files
+	board_t semi_open_files[2];
+
+	int16_t passed_pawn_score[2];
+	// pawns without another pawn of the same color on their file
+	uint8_t lone_pawns[2];
+
+	// the shelter also depends on the king, it is recomputed when the king isn't on the saved square anymore
+	uint8_t king_square[2];
+	int16_t shelter_score[2];
+
+	bool filled;
+};
+
+/*
+https://www.chessprogramming.org/Pawn_Hash_Table
+the pawns change in a small part of the moves so most positions of a search share their pawn structure with many others.
+the pawn terms are computed once per structure and saved under the pawn key, always replacing what was in the slot.
+every search thread has its own table
+*/
+class PawnHashTable
+{
+	vector<pawn_hash_entry> entries;
+	uint64_t index_mask = 0;
+
+public:
+	uint64_t probes = 0;
+	uint64_t hits = 0;
+
+	PawnHashTable(size_t size_mb)
+	{
+		resize(size_mb);
+	}
+
+	// the amount of entries is rounded down to a power of 2 so the index is just a mask
+	void resize(size_t size_mb)
+	{
+		size_t count = bit_floor(max<size_t>(1, size_mb * 1024 * 1024 / sizeof(pawn_hash_entry)));
+
+		entries.assign(count, pawn_hash_entry{});
+		index_mask = count - 1;
+	}
+
+	size_t size_mb() const
+	{
+		return entries.size() * sizeof(pawn_hash_entry) / (1024 * 1024);
+	}
+
+	// returns the slot of the pawn structure, found is false when the slot belongs to a different structure and has to be filled in
+	pawn_hash_entry& probe(uint64_t pawn_key, bool& found)
+	{
+		pawn_hash_entry& entry = entries[pawn_key & index_mask];
+		found = entry.filled && entry.key == pawn_key;
+
+		probes++;
+		if (found)
+			hits++;
+
+		return entry;
+	}
+
+	void reset_counters()
+	{
+		probes = 0;
+		hits = 0;
+	}
+
+	// percentage of probes that found their pawn structure
+	double hit_rate() const
+	{
+		return probes ? 100.0 * hits / probes : 0;
+	}
+};
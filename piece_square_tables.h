@@ -0,0 +1,158 @@
+#pragma once
+
+#include <cstdint>
+#include <array>
+
+/*
+https://www.chessprogramming.org/Piece-Square_Tables
+https://www.chessprogramming.org/Tapered_Eval
+material and piece square values of every (piece, square) pair, the board adds them up while pieces move
+so the evaluation only has to read the sum.
+every value has a middlegame and an endgame part, both are packed in to one int so a single addition updates both
+*/
+
+// the tables are written from whites point of view with the 8th rank first
+inline constexpr int pawns_early_square_table[64] = {
+     0,  0,  0,  0,  0,  0,  0,  0,
+    50, 50, 50, 50, 50, 50, 50, 50,
+    10, 10, 20, 30, 30, 20, 10, 10,
+     5,  5, 10, 25, 25, 10,  5,  5,
+     0,  0,  0, 20, 20,  0,  0,  0,
+     5, -5,-10,  0,  0,-10, -5,  5,
+     5, 10, 10,-20,-20, 10, 10,  5,
+     0,  0,  0,  0,  0,  0,  0,  0
+};
+
+inline constexpr int pawns_end_square_table[64] = {
+     0,  0,  0,  0,  0,  0,  0,  0,
+    90, 95, 90, 80, 80, 90, 95, 90,
+    50, 70, 50, 45, 45, 50, 70, 50,
+    23, 25, 23, 18, 18, 23, 25, 23,
+    15, 18, 15, 15, 15, 15, 18, 15,
+    15, 15, 15, 15, 15, 15, 15, 15,
+    15, 15, 15, 18, 18, 15, 15, 15,
+     0,  0,  0,  0,  0,  0,  0,  0
+};
+
+inline constexpr int rooks_square_table[64] = {
+     0,  0,  0,  0,  0,  0,  0,  0,
+     5, 10, 10, 10, 10, 10, 10,  5,
+    -5,  0,  0,  0,  0,  0,  0, -5,
+    -5,  0,  0,  0,  0,  0,  0, -5,
+    -5,  0,  0,  0,  0,  0,  0, -5,
+    -5,  0,  0,  0,  0,  0,  0, -5,
+    -5,  0,  0,  0,  0,  0,  0, -5,
+     0,  0,  0,  5,  5,  0,  0,  0
+};
+
+inline constexpr int knights_square_table[64] = {
+    -50,-40,-30,-30,-30,-30,-40,-50,
+    -40,-20,  0,  0,  0,  0,-20,-40,
+    -30,  0, 10, 15, 15, 10,  0,-30,
+    -30,  5, 15, 20, 20, 15,  5,-30,
+    -30,  0, 15, 20, 20, 15,  0,-30,
+    -30,  5, 10, 15, 15, 10,  5,-30,
+    -40,-20,  0,  5,  5,  0,-20,-40,
+    -50,-40,-30,-30,-30,-30,-40,-50,
+};
+
+inline constexpr int bishops_square_table[64] = {
+    -20,-10,-10,-10,-10,-10,-10,-20,
+    -10,  0,  0,  0,  0,  0,  0,-10,
+    -10,  0,  5, 10, 10,  5,  0,-10,
+    -10,  5,  5, 10, 10,  5,  5,-10,
+    -10,  0, 10, 10, 10, 10,  0,-10,
+    -10, 10, 10, 10, 10, 10, 10,-10,
+    -10,  5,  0,  0,  0,  0,  5,-10,
+    -20,-10,-10,-10,-10,-10,-10,-20,
+};
+
+inline constexpr int queens_square_table[64] = {
+    -20,-10,-10, -5, -5,-10,-10,-20,
+    -10,  0,  0,  0,  0,  0,  0,-10,
+    -10,  0,  5,  5,  5,  5,  0,-10,
+     -5,  0,  5,  5,  5,  5,  0, -5,
+      0,  0,  5,  5,  5,  5,  0, -5,
+    -10,  5,  5,  5,  5,  5,  0,-10,
+    -10,  0,  5,  0,  0,  0,  0,-10,
+    -20,-10,-10, -5, -5,-10,-10,-20
+};
+
+inline constexpr int king_early_square_table[64] = {
+    -80,-70,-70,-70,-70,-70,-70,-80,
+    -60,-60,-60,-60,-60,-60,-60,-60,
+    -40,-50,-50,-60,-60,-50,-50,-40,
+    -30,-40,-40,-50,-50,-40,-40,-30,
+    -20,-30,-30,-40,-40,-30,-30,-20,
+    -10,-20,-20,-20,-20,-20,-20,-10,
+     20, 20, -5, -5, -5, -5, 20, 20,
+     20, 30, 10,  0,  0, 10, 30, 20
+};
+
+inline constexpr int king_end_square_table[64] = {
+    -50,-40,-30,-20,-20,-30,-40,-50,
+    -30,-20,-10,  0,  0,-10,-20,-30,
+    -30,-10, 20, 30, 30, 20,-10,-30,
+    -30,-10, 30, 40, 40, 30,-10,-30,
+    -30,-10, 30, 40, 40, 30,-10,-30,
+    -30,-10, 20, 30, 30, 20,-10,-30,
+    -30,-30,  0,  0,  0,  0,-30,-30,
+    -50,-30,-30,-30,-30,-30,-30,-50
+};
+
+// indexed by piece_no_color_t
+inline constexpr int piece_values[8] = { 0, 0, 100, 300, 325, 500, 900, 0 };
+
+// how much a piece counts towards the middlegame, the endgame weight of a side goes from 0 to 1 as it drops from endgame_material_start to 0
+// indexed by piece_no_color_t
+inline constexpr int endgame_material_values[8] = { 0, 0, 0, 1, 1, 2, 4, 0 };
+
+// middlegame value in the lower 16 bits, endgame value in the upper 16 bits
+using score_t = int32_t;
+
+constexpr score_t make_score(int middlegame, int endgame)
+{
+    return (score_t)((uint32_t)endgame << 16) + middlegame;
+}
+
+constexpr int get_middlegame_score(score_t score)
+{
+    return (int16_t)(uint16_t)(uint32_t)score;
+}
+
+// the rounding makes up for the borrow from the middlegame part when it is negative
+constexpr int get_endgame_score(score_t score)
+{
+    return (int16_t)(uint16_t)((uint32_t)(score + 0x8000) >> 16);
+}
+
+// indexed by piece_t and square, black pieces have negative scores so the sum is from whites point of view
+constexpr std::array<std::array<score_t, 64>, 16> generate_piece_square_scores()
+{
+    std::array<std::array<score_t, 64>, 16> scores = {};
+
+    // middlegame and endgame table of every piece_no_color_t
+    const int* middlegame_tables[7] = { nullptr, king_early_square_table, pawns_early_square_table, knights_square_table, bishops_square_table, rooks_square_table, queens_square_table };
+    const int* endgame_tables[7] = { nullptr, king_end_square_table, pawns_end_square_table, knights_square_table, bishops_square_table, rooks_square_table, queens_square_table };
+
+    for (int piece = 1; piece <= 6; piece++)
+    {
+        for (int square = 0; square < 64; square++)
+        {
+            // the tables start with the 8th rank so for white the square is mirrored, for black it already is
+            int mirror_square = 8 * (7 - square / 8) + (square % 8);
+
+            scores[piece][square] = make_score(
+                piece_values[piece] + middlegame_tables[piece][mirror_square],
+                piece_values[piece] + endgame_tables[piece][mirror_square]);
+
+            scores[piece + 8][square] = -make_score(
+                piece_values[piece] + middlegame_tables[piece][square],
+                piece_values[piece] + endgame_tables[piece][square]);
+        }
+    }
+
+    return scores;
+}
+
+inline constexpr std::array<std::array<score_t, 64>, 16> piece_square_scores = generate_piece_square_scores();
@@ -0,0 +1,72 @@
+#pragma once
+
+#include <cstdint>
+#include <vector>
+#include <algorithm>
+
+using namespace std;
+
+/*
+https://www.chessprogramming.org/Repetitions
+keys of every position before the current one, first the positions of the played game and then the ones on the current search path.
+only positions after the last irreversible move (pawn move, capture or null move) can be the same as the current one
+and only every second one has the same side to move, so that is all that gets compared
+*/
+class RepetitionHistory
+{
+	vector<uint64_t> keys;
+	// the keys before this index come from the game, the rest from the search
+	size_t root_size = 0;
+
+public:
+	void clear()
+	{
+		keys.clear();
+		root_size = 0;
+	}
+
+	// a move was played in the game, called before the move is made on the board
+	void add_game_position(uint64_t key)
+	{
+		keys.resize(root_size);
+		keys.push_back(key);
+		root_size = keys.size();
+	}
+
+	// removes whatever a canceled search left behind
+	void reset_search()
+	{
+		keys.resize(root_size);
+	}
+
+	// search calls push before making a move and pop after undoing it
+	void push(uint64_t key)
+	{
+		keys.push_back(key);
+	}
+
+	void pop()
+	{
+		keys.pop_back();
+	}
+
+	// reversible_plies is the halfmove clock of the current position
+	// a position that was already on the search path is a draw right away (if repeating is the best either side can do the search can just assume it),
+	// a position from the game has to be there twice already to be a 3 fold repetition
+	bool is_repetition(uint64_t key, int reversible_plies) const
+	{
+		int game_repetitions = 0;
+		int stop = max(0, (int)keys.size() - reversible_plies);
+
+		for (int i = (int)keys.size() - 2; i >= stop; i -= 2)
+		{
+			if (keys[i] != key)
+				continue;
+
+			if (i >= (int)root_size || ++game_repetitions == 2)
+				return true;
+		}
+
+		return false;
+	}
+};
@@ -0,0 +1,71 @@
+#pragma once
+
+#include <string>
+#include <vector>
+#include <utility>
+
+using namespace std;
+
+/*
+the numbers of the pruning, reductions and evaluation that are worth tuning.
+every computer has its own copy (shared with its helper threads) so two computers with different parameters
+can play against each other, the defaults are the values the engine plays with
+*/
+struct search_parameters_t
+{
+	// https://www.chessprogramming.org/Reverse_Futility_Pruning
+	// a node is cut when the static eval is above beta by this much per remaining depth
+	int rfp_margin = 75;
+	int rfp_max_depth = 6;
+
+	// https://www.chessprogramming.org/Null_Move_Pruning
+	// the null move is searched this much shallower, only from the minimum depth and with at least this much endgame material on the board
+	int null_move_reduction = 4;
+	int null_move_min_depth = 3;
+	int null_move_min_material = 2;
+
+	// https://www.chessprogramming.org/Late_Move_Reductions
+	// quiet moves after the first few are searched with a reduced depth first
+	int lmr_reduction = 1;
+	int lmr_min_depth = 3;
+	int lmr_min_moves = 5;
+
+	// percentages of the evaluation terms
+	int mobility_weight = 100;
+	int king_attack_weight = 100;
+	int king_safety_weight = 100;
+
+	// every parameter by name, for the tools that set them from the command line
+	static const vector<pair<string, int search_parameters_t::*>>& names()
+	{
+		static const vector<pair<string, int search_parameters_t::*>> list =
+		{
+			{ "rfp_margin", &search_parameters_t::rfp_margin },
+			{ "rfp_max_depth", &search_parameters_t::rfp_max_depth },
+			{ "null_move_reduction", &search_parameters_t::null_move_reduction },
+			{ "null_move_min_depth", &search_parameters_t::null_move_min_depth },
+			{ "null_move_min_material", &search_parameters_t::null_move_min_material },
+			{ "lmr_reduction", &search_parameters_t::lmr_reduction },
+			{ "lmr_min_depth", &search_parameters_t::lmr_min_depth },
+			{ "lmr_min_moves", &search_parameters_t::lmr_min_moves },
+			{ "mobility_weight", &search_parameters_t::mobility_weight },
+			{ "king_attack_weight", &search_parameters_t::king_attack_weight },
+			{ "king_safety_weight", &search_parameters_t::king_safety_weight },
+		};
+		return list;
+	}
+
+	// returns false if there is no parameter with this name
+	bool set(const string& name, int value)
+	{
+		for (const auto& parameter : names())
+		{
+			if (parameter.first == name)
+			{
+				this->*parameter.second = value;
+				return true;
+			}
+		}
+		return false;
+	}
+};
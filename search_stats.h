@@ -0,0 +1,146 @@
+#pragma once
+
+#include <cstdint>
+#include <chrono>
+#include <string>
+#include <vector>
+#include <sstream>
+
+using namespace std;
+
+// one finished iteration of the iterative deepening
+struct search_depth_stats_t
+{
+	int depth;
+	int eval;
+	// nodes and wall time of this iteration alone (including aspiration window re-searches)
+	uint64_t nodes;
+	chrono::milliseconds time;
+	uint64_t nps;
+};
+
+/*
+counters of one search thread, reset at the start of every search.
+they are plain integers only touched by the thread that owns them so they can stay on all the time,
+after the search the counters of the helper threads are summed in with add()
+*/
+struct SearchStats
+{
+	// calls of search and search_captures
+	uint64_t nodes = 0;
+	uint64_t qnodes = 0;
+	uint64_t evaluations = 0;
+
+	uint64_t tt_probes = 0;
+	uint64_t tt_hits = 0;
+	// the entry was used instead of searching the position
+	uint64_t tt_cutoffs = 0;
+
+	// beta cutoffs and how many of them came from the first searched move, a high share means good move ordering
+	uint64_t fail_highs = 0;
+	uint64_t fail_highs_first = 0;
+
+	uint64_t null_move_prunes = 0;
+	uint64_t rfp_prunes = 0;
+
+	// reduced searches of late moves and how many of them had to be searched again at full depth
+	uint64_t lmr_searches = 0;
+	uint64_t lmr_researches = 0;
+
+	// only filled by the thread that prints the search info
+	vector<search_depth_stats_t> depths;
+
+	chrono::steady_clock::time_point start_time;
+	chrono::steady_clock::time_point last_depth_time;
+	uint64_t last_depth_nodes = 0;
+
+	void start()
+	{
+		*this = SearchStats();
+		start_time = chrono::steady_clock::now();
+		last_depth_time = start_time;
+	}
+
+	uint64_t total_nodes() const
+	{
+		return nodes + qnodes;
+	}
+
+	chrono::milliseconds elapsed() const
+	{
+		return chrono::duration_cast<chrono::milliseconds>(chrono::steady_clock::now() - start_time);
+	}
+
+	void add_depth(int depth, int eval)
+	{
+		chrono::steady_clock::time_point now = chrono::steady_clock::now();
+		chrono::microseconds time = chrono::duration_cast<chrono::microseconds>(now - last_depth_time);
+		uint64_t depth_nodes = total_nodes() - last_depth_nodes;
+
+		uint64_t nps = time.count() ? depth_nodes * 1'000'000 / time.count() : 0;
+		depths.push_back({ depth, eval, depth_nodes, chrono::duration_cast<chrono::milliseconds>(time), nps });
+
+		last_depth_time = now;
+		last_depth_nodes = total_nodes();
+	}
+
+	// sums the counters of another thread, the depths stay the ones of this thread
+	void add(const SearchStats& other)
+	{
+		nodes += other.nodes;
+		qnodes += other.qnodes;
+		evaluations += other.evaluations;
+		tt_probes += other.tt_probes;
+		tt_hits += other.tt_hits;
+		tt_cutoffs += other.tt_cutoffs;
+		fail_highs += other.fail_highs;
+		fail_highs_first += other.fail_highs_first;
+		null_move_prunes += other.null_move_prunes;
+		rfp_prunes += other.rfp_prunes;
+		lmr_searches += other.lmr_searches;
+		lmr_researches += other.lmr_researches;
+	}
+
+	// percentage of beta cutoffs caused by the first move
+	double fail_high_first_rate() const
+	{
+		return fail_highs ? 100.0 * fail_highs_first / fail_highs : 0;
+	}
+
+	// https://www.chessprogramming.org/Branching_Factor#EffectiveBranchingFactor
+	// nodes of the last iteration divided by the nodes of the one before it
+	double effective_branching_factor() const
+	{
+		if (depths.size() < 2 || depths[depths.size() - 2].nodes == 0)
+			return 0;
+
+		return (double)depths.back().nodes / depths[depths.size() - 2].nodes;
+	}
+
+	static string depth_to_json(const search_depth_stats_t& depth)
+	{
+		stringstream json;
+		json << "{\"depth\":" << depth.depth << ",\"eval\":" << depth.eval << ",\"nodes\":" << depth.nodes;
+		json << ",\"time_ms\":" << depth.time.count() << ",\"nps\":" << depth.nps << "}";
+		return json.str();
+	}
+
+	// the whole search as one line of json
+	string to_json() const
+	{
+		stringstream json;
+		json << "{\"nodes\":" << nodes << ",\"qnodes\":" << qnodes << ",\"evaluations\":" << evaluations;
+		json << ",\"tt_probes\":" << tt_probes << ",\"tt_hits\":" << tt_hits << ",\"tt_cutoffs\":" << tt_cutoffs;
+		json << ",\"fail_highs\":" << fail_highs << ",\"fail_high_first_rate\":" << fail_high_first_rate();
+		json << ",\"null_move_prunes\":" << null_move_prunes << ",\"rfp_prunes\":" << rfp_prunes;
+		json << ",\"lmr_searches\":" << lmr_searches << ",\"lmr_researches\":" << lmr_researches;
+		json << ",\"ebf\":" << effective_branching_factor() << ",\"time_ms\":" << elapsed().count();
+
+		json << ",\"depths\":[";
+		for (size_t i = 0; i < depths.size(); i++)
+			json << (i ? "," : "") << depth_to_json(depths[i]);
+		json << "]}";
+
+		return json.str();
+	}
+};
@@ -0,0 +1,121 @@
+#pragma once
+
+#include <cstdint>
+#include <chrono>
+#include <algorithm>
+#include <atomic>
+
+using namespace std;
+
+// what a search is allowed to use
+struct search_limits_t
+{
+	// fixed time for the move, when it is set the clock below is ignored
+	chrono::milliseconds move_time{ 0 };
+
+	// time left on the clock of the side to move and its increment per move
+	chrono::milliseconds time_left{ 0 };
+	chrono::milliseconds increment{ 0 };
+	// moves until the next time control, 0 means the time has to last for the rest of the game
+	int moves_to_go = 0;
+
+	// limits that don't depend on the time, 0 means no limit
+	int depth = 0;
+	uint64_t nodes = 0;
+
+	// the search only ends when it is stopped from the outside
+	bool infinite = false;
+
+	// the search is thinking on the time of the opponent, the limits only apply after a ponder hit
+	bool ponder = false;
+};
+
+/*
+https://www.chessprogramming.org/Time_Management
+the soft limit is checked between the iterations of the iterative deepening, a new depth isn't started after it.
+the hard limit is checked inside of the search every few thousand nodes and stops it right away.
+while the best move keeps changing between iterations the soft limit is extended (up to the hard limit)
+because the search hasn't settled on a move yet.
+a pondering search ignores the limits until ponder_hit(), the time is measured from the start of the pondering
+so the time spent on the opponent's turn counts as already used
+*/
+class TimeManager
+{
+	using clock = chrono::steady_clock;
+
+	// kept on the clock for everything that happens outside of the search (sending the move, drawing the board)
+	static constexpr chrono::milliseconds move_overhead{ 10 };
+	// the time is split as if this many moves were left when the time control doesn't say
+	static constexpr int default_moves_to_go = 30;
+
+	clock::time_point start_time;
+	chrono::milliseconds soft_limit{ 0 };
+	chrono::milliseconds hard_limit{ 0 };
+
+	// increased every time the best move changes and halved after every iteration
+	double best_move_changes = 0;
+
+	// a search without limits (the helper threads) is only stopped from the outside
+	bool active = false;
+	// set on a different thread than the one searching
+	atomic<bool> pondering = false;
+
+public:
+	// without a move time or a clock the search has no time limit
+	void start(const search_limits_t& limits)
+	{
+		start_time = clock::now();
+		best_move_changes = 0;
+		active = !limits.infinite && (limits.move_time.count() > 0 || limits.time_left.count() > 0);
+		pondering = limits.ponder;
+
+		if (limits.move_time.count() > 0)
+		{
+			soft_limit = limits.move_time;
+			hard_limit = limits.move_time;
+			return;
+		}
+
+		int moves_to_go = limits.moves_to_go > 0 ? limits.moves_to_go : default_moves_to_go;
+		chrono::milliseconds available = max(limits.time_left - move_overhead, chrono::milliseconds(1));
+
+		soft_limit = min(available / moves_to_go + limits.increment * 3 / 4, available);
+		hard_limit = min(soft_limit * 4, available);
+	}
+
+	void stop()
+	{
+		active = false;
+	}
+
+	// the opponent played the expected move, from now on the search has the limits it was started with
+	void ponder_hit()
+	{
+		pondering = false;
+	}
+
+	chrono::milliseconds elapsed() const
+	{
+		return chrono::duration_cast<chrono::milliseconds>(clock::now() - start_time);
+	}
+
+	bool hard_limit_reached() const
+	{
+		return active && !pondering && clock::now() - start_time >= hard_limit;
+	}
+
+	// called after every finished iteration, returns true when the next one shouldn't be started
+	bool soft_limit_reached(bool best_move_changed)
+	{
+		if (!active)
+			return false;
+
+		best_move_changes = best_move_changes / 2 + (best_move_changed ? 1 : 0);
+		if (pondering)
+			return false;
+
+		// an unstable best move gets up to twice the soft limit
+		chrono::duration<double, milli> limit = soft_limit * (1.0 + min(best_move_changes, 2.0) / 2);
+		return clock::now() - start_time >= min(limit, chrono::duration<double, milli>(hard_limit));
+	}
+};
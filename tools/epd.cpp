@@ -0,0 +1,450 @@
+// epd.cpp
+//
+// headless batch analysis of a file of positions, for game reviews, puzzle mining and test suites
+// https://www.chessprogramming.org/Extended_Position_Description
+//
+// usage:
+//   epd <file> [options]        reads one fen or epd per line (- reads from stdin), the results go to stdout
+// options:
+//   --depth N        searches every position to depth N (the default is 8 when no other limit is given)
+//   --nodes N        stops every search after N nodes
+//   --movetime T     gives every position T milliseconds
+//   --threads N      amount of workers, each one analyses its own position (the default is every core)
+//   --hash MB        transposition table of every worker
+//   --json           writes json lines instead of csv
+//
+// the results are written in the order of the input, the bm (best move) and am (avoid move) opcodes
+// of test suites are checked against the found move and the solve rate is printed at the end
+
+#include <iostream>
+#include <fstream>
+#include <sstream>
+#include <iomanip>
+#include <string>
+#include <vector>
+#include <map>
+#include <thread>
+#include <mutex>
+#include <atomic>
+#include <chrono>
+#include <algorithm>
+
+#include "../board.h"
+#include "../computer.h"
+
+using namespace std;
+
+const int default_depth = 8;
+const int default_hash_mb = 16;
+
+struct epd_options_t
+{
+	search_limits_t limits;
+	int threads = max(1, (int)thread::hardware_concurrency());
+	size_t hash_mb = default_hash_mb;
+	bool json = false;
+};
+
+// one line of the input
+struct epd_position_t
+{
+	string fen;
+	string id;
+	vector<string> best_moves;
+	vector<string> avoid_moves;
+	// the line couldn't be read as a position
+	bool invalid = false;
+};
+
+struct epd_result_t
+{
+	string best_move = "0000";
+	string score;
+	int depth = 0;
+	uint64_t nodes = 0;
+	string pv;
+	// -1 when the position has no bm or am opcode, otherwise 0 or 1
+	int solved = -1;
+};
+
+// the opcodes that aren't needed here are skipped
+void parse_operations(const string& rest, epd_position_t& position)
+{
+	// operations end with a semicolon, the semicolons inside of quoted operands don't count
+	vector<string> operations(1);
+	bool quoted = false;
+	for (char c : rest)
+	{
+		if (c == '"')
+			quoted = !quoted;
+
+		if (c == ';' && !quoted)
+			operations.emplace_back();
+		else
+			operations.back().push_back(c);
+	}
+
+	for (const string& operation : operations)
+	{
+		istringstream operands(operation);
+		string opcode;
+		if (!(operands >> opcode))
+			continue;
+
+		string operand;
+		if (opcode == "bm" || opcode == "am")
+		{
+			while (operands >> operand)
+				(opcode == "bm" ? position.best_moves : position.avoid_moves).push_back(operand);
+		}
+		else if (opcode == "id")
+		{
+			getline(operands >> ws, operand);
+			position.id = operand.size() >= 2 && operand.front() == '"' && operand.back() == '"' ? operand.substr(1, operand.size() - 2) : operand;
+		}
+		else if (opcode == "hmvc" && operands >> operand && all_of(operand.begin(), operand.end(), ::isdigit))
+			position.fen += " " + operand;
+	}
+}
+
+// a fen has the halfmove clock and the move number after the first 4 fields, an epd has operations ("bm Nf3; id "test 1";")
+epd_position_t parse_line(const string& line)
+{
+	epd_position_t position;
+
+	istringstream stream(line);
+	vector<string> fields;
+	string field;
+	while (fields.size() < 4 && stream >> field)
+		fields.push_back(field);
+
+	bool en_passant_valid = fields.size() >= 4 && (fields[3] == "-" || (fields[3].size() == 2 && fields[3][0] >= 'a' && fields[3][0] <= 'h' && (fields[3][1] == '3' || fields[3][1] == '6')));
+	if (fields.size() < 4 || (fields[1] != "w" && fields[1] != "b") || !en_passant_valid)
+	{
+		position.invalid = true;
+		return position;
+	}
+
+	position.fen = fields[0] + " " + fields[1] + " " + fields[2] + " " + fields[3];
+
+	string rest;
+	getline(stream, rest);
+
+	// the counters of a plain fen
+	istringstream counters(rest);
+	string halfmove_clock, move_number;
+	if (counters >> halfmove_clock >> move_number && all_of(halfmove_clock.begin(), halfmove_clock.end(), ::isdigit) && all_of(move_number.begin(), move_number.end(), ::isdigit))
+		position.fen += " " + halfmove_clock + " " + move_number;
+	else
+		parse_operations(rest, position);
+
+	// a broken position would crash the worker and with it the whole batch
+	ChessBoard board;
+	board.from_fen(position.fen);
+	position.invalid = !board.is_legal_position();
+
+	return position;
+}
+
+// https://www.chessprogramming.org/Algebraic_Chess_Notation#SAN
+// the check and annotation marks are left out, test suites don't always write them
+string move_to_san(ChessBoard& board, move_t chess_move, MoveList& moves)
+{
+	square_t from = board.get_move_from(chess_move);
+	square_t to = board.get_move_to(chess_move);
+	piece_no_color_t piece = (piece_no_color_t)((int)board.get_piece_type(from) % 8);
+
+	if (piece == piece_no_color_t::king && (to == from + 2 || from == to + 2))
+		return to > from ? "O-O" : "O-O-O";
+
+	string square = board.move_t_to_uci(chess_move).substr(2, 2);
+	string san;
+
+	if (piece == piece_no_color_t::pawn)
+	{
+		if (board.is_capture(chess_move))
+			san += string(1, (char)('a' + from % 8)) + "x";
+		san += square;
+
+		piece_t promotion = board.get_promotion(chess_move);
+		if (promotion != piece_t::empty)
+			san += string("=") + "  PNBRQ"[(int)promotion % 8];
+
+		return san;
+	}
+
+	san += " KPNBRQ"[(int)piece];
+
+	// another piece of the same type that can go to the same square
+	bool ambiguous = false, same_file = false, same_rank = false;
+	for (move_t other : moves)
+	{
+		square_t other_from = board.get_move_from(other);
+		if (other_from == from || board.get_move_to(other) != to || board.get_piece_type(other_from) != board.get_piece_type(from))
+			continue;
+
+		ambiguous = true;
+		same_file |= other_from % 8 == from % 8;
+		same_rank |= other_from / 8 == from / 8;
+	}
+
+	if (ambiguous && (!same_file || same_rank))
+		san.push_back((char)('a' + from % 8));
+	if (ambiguous && same_file)
+		san.push_back((char)('1' + from / 8));
+
+	if (board.is_capture(chess_move))
+		san += "x";
+
+	return san + square;
+}
+
+// removes the marks the suites write in different ways ("Nf3+", "e8=Q", "e8Q", "0-0")
+string normalize_san(string san)
+{
+	string normalized;
+	for (char c : san)
+	{
+		if (c == '0')
+			normalized.push_back('O');
+		else if (string("+#!?=").find(c) == string::npos)
+			normalized.push_back(c);
+	}
+	return normalized;
+}
+
+// the moves of the opcodes can be in san or in uci notation
+bool is_move_in(const vector<string>& list, const string& san, const string& uci)
+{
+	for (const string& chess_move : list)
+	{
+		if (normalize_san(chess_move) == normalize_san(san) || chess_move == uci)
+			return true;
+	}
+	return false;
+}
+
+epd_result_t analyse(Computer& computer, const epd_position_t& position, const search_limits_t& limits)
+{
+	epd_result_t result;
+
+	ChessBoard board;
+	board.from_fen(position.fen);
+
+	MoveList moves;
+	board.generate_moves(moves);
+	if (moves.empty())
+		return result;
+
+	computer.set_board(board);
+	move_t best_move = computer.deapening_search(limits).first;
+
+	SearchStats stats = computer.get_search_stats();
+	vector<search_line_t> lines = computer.get_pv_lines();
+
+	result.best_move = board.move_t_to_uci(best_move);
+	result.nodes = stats.total_nodes();
+	if (!lines.empty())
+	{
+		result.score = computer.uci_score(lines[0].eval);
+		result.depth = lines[0].depth;
+
+		ChessBoard pv_board = board;
+		for (move_t chess_move : lines[0].pv)
+		{
+			result.pv += (result.pv.empty() ? "" : " ") + pv_board.move_t_to_uci(chess_move);
+			pv_board.move(chess_move);
+		}
+	}
+
+	if (!position.best_moves.empty() || !position.avoid_moves.empty())
+	{
+		string san = move_to_san(board, best_move, moves);
+		bool best = position.best_moves.empty() || is_move_in(position.best_moves, san, result.best_move);
+		bool avoided = position.avoid_moves.empty() || !is_move_in(position.avoid_moves, san, result.best_move);
+		result.solved = best && avoided;
+	}
+
+	return result;
+}
+
+string escape_json(const string& s)
+{
+	string escaped;
+	for (char c : s)
+	{
+		if (c == '"' || c == '\\')
+			escaped.push_back('\\');
+		escaped.push_back(c);
+	}
+	return escaped;
+}
+
+string format_result(size_t index, const epd_position_t& position, const epd_result_t& result, bool json)
+{
+	stringstream line;
+	if (json)
+	{
+		line << "{\"index\":" << index << ",\"id\":\"" << escape_json(position.id) << "\",\"fen\":\"" << escape_json(position.fen) << "\"";
+		if (position.invalid)
+		{
+			line << ",\"error\":\"invalid position\"}";
+			return line.str();
+		}
+
+		line << ",\"bestmove\":\"" << result.best_move << "\",\"score\":\"" << result.score << "\",\"depth\":" << result.depth;
+		line << ",\"nodes\":" << result.nodes << ",\"pv\":\"" << result.pv << "\"";
+		if (result.solved >= 0)
+			line << ",\"solved\":" << (result.solved ? "true" : "false");
+		line << "}";
+	}
+	else
+	{
+		// the id and the fen are quoted because they can contain commas and spaces
+		line << index << ",\"" << position.id << "\",\"" << position.fen << "\",";
+		if (!position.invalid)
+		{
+			line << result.best_move << "," << result.score << "," << result.depth << "," << result.nodes << "," << result.pv << ",";
+			line << (result.solved < 0 ? "" : to_string(result.solved));
+		}
+		else
+			line << ",,,,,";
+	}
+
+	return line.str();
+}
+
+int main(int argc, char* argv[])
+{
+	epd_options_t options;
+	string file;
+
+	for (int i = 1; i < argc; i++)
+	{
+		string arg = argv[i];
+
+		if (arg == "--depth" && i + 1 < argc)
+			options.limits.depth = stoi(argv[++i]);
+		else if (arg == "--nodes" && i + 1 < argc)
+			options.limits.nodes = stoull(argv[++i]);
+		else if (arg == "--movetime" && i + 1 < argc)
+			options.limits.move_time = chrono::milliseconds(stoll(argv[++i]));
+		else if (arg == "--threads" && i + 1 < argc)
+			options.threads = max(1, stoi(argv[++i]));
+		else if (arg == "--hash" && i + 1 < argc)
+			options.hash_mb = max<size_t>(1, stoul(argv[++i]));
+		else if (arg == "--json")
+			options.json = true;
+		else if (file.empty() && (arg == "-" || arg[0] != '-'))
+			file = arg;
+		else
+		{
+			cout << "unknown option: " << arg << endl;
+			return 1;
+		}
+	}
+
+	if (file.empty())
+	{
+		cout << "usage: epd <file> [--depth N] [--nodes N] [--movetime T] [--threads N] [--hash MB] [--json]" << endl;
+		return 1;
+	}
+
+	if (!options.limits.depth && !options.limits.nodes && !options.limits.move_time.count())
+		options.limits.depth = default_depth;
+
+	ifstream file_stream;
+	if (file != "-")
+	{
+		file_stream.open(file);
+		if (!file_stream)
+		{
+			cout << "can't open " << file << endl;
+			return 1;
+		}
+	}
+	istream& input = file != "-" ? file_stream : cin;
+
+	if (!options.json)
+		cout << "index,id,fen,bestmove,score,depth,nodes,pv,solved" << endl;
+
+	// the file is read line by line by the workers themselves, so a huge file never has to fit in memory
+	mutex input_mutex;
+	size_t next_index = 0;
+
+	// a worker that finishes early keeps its line here until all the lines before it are written
+	mutex output_mutex;
+	map<size_t, string> finished;
+	size_t next_output = 0;
+
+	atomic<uint64_t> total_nodes = 0;
+	atomic<int> tested = 0;
+	atomic<int> solved = 0;
+
+	auto worker = [&]()
+		{
+			Computer computer;
+			computer.set_info_output(info_output_t::none);
+			computer.set_hash_size(options.hash_mb);
+
+			while (true)
+			{
+				string line;
+				size_t index;
+				{
+					lock_guard<mutex> lock(input_mutex);
+					while (getline(input, line) && (all_of(line.begin(), line.end(), ::isspace) || line[0] == '#'));
+					if (!input && line.empty())
+						return;
+					// files written on windows
+					if (line.back() == '\r')
+						line.pop_back();
+					index = next_index++;
+				}
+
+				epd_position_t position = parse_line(line);
+				epd_result_t result;
+				if (!position.invalid)
+					result = analyse(computer, position, options.limits);
+
+				total_nodes += result.nodes;
+				if (result.solved >= 0)
+				{
+					tested++;
+					solved += result.solved;
+				}
+
+				lock_guard<mutex> lock(output_mutex);
+				finished[index] = format_result(index, position, result, options.json);
+				for (auto it = finished.find(next_output); it != finished.end(); it = finished.find(next_output))
+				{
+					cout << it->second << '\n';
+					finished.erase(it);
+					next_output++;
+				}
+			}
+		};
+
+	auto start = chrono::steady_clock::now();
+
+	vector<thread> threads;
+	for (int i = 0; i < options.threads; i++)
+		threads.emplace_back(worker);
+
+	for (thread& t : threads)
+		t.join();
+
+	cout.flush();
+
+	double seconds = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+
+	// the summary goes to stderr so the results can be piped into a file
+	cerr << "positions " << next_index << " time " << fixed << setprecision(3) << seconds << "s"
+		<< " positions/hour " << (uint64_t)(seconds > 0 ? next_index * 3600 / seconds : 0)
+		<< " nps " << (uint64_t)(seconds > 0 ? total_nodes / seconds : 0) << endl;
+
+	if (tested)
+		cerr << "solved " << solved << " of " << tested << " (" << setprecision(1) << 100.0 * solved / tested << "%)" << endl;
+
+	return 0;
+}
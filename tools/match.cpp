@@ -0,0 +1,609 @@
+// match.cpp
+//
+// headless self-play match between two engine configurations (a and b), the games run concurrently on every core
+// https://www.chessprogramming.org/Match_Statistics
+// https://www.chessprogramming.org/Sequential_Probability_Ratio_Test
+//
+// usage:
+//   match [options]
+// options:
+//   --games N              amount of games, every opening is played twice with swapped colors (default 100)
+//   --concurrency N        games played at the same time (the default is every core)
+//   --openings <file>      one fen, epd or list of uci moves from the start position per line (a small built-in book otherwise)
+//   --tc S+I               clock of S seconds with an increment of I seconds per move (default 1+0.01)
+//   --movetime T           fixed T milliseconds per move instead of a clock
+//   --nodes N              fixed N nodes per move instead of a clock
+//   --depth N              fixed depth per move instead of a clock
+//   --hash MB              transposition table of every engine (default 16)
+//   --threads N            search threads of every engine (default 1)
+//   --param NAME=VALUE     sets a search or evaluation parameter (search_parameters.h), e.g. --a-param rfp_margin=90
+//   --sprt E0 E1           stops as soon as the sequential probability ratio test accepts elo E0 or elo E1 for a
+//   --alpha A --beta B     error probabilities of the sprt (default 0.05 and 0.05)
+//   --resign-score CP --resign-moves N                    a game is lost once both engines agree on an eval of at least CP for N moves (0 disables it)
+//   --draw-score CP --draw-moves N --draw-after N         a game is drawn once the eval stays within CP for N moves after move N
+//   --max-moves N          a game that lasts longer is a draw (default 300)
+//
+// every search option can be given to one engine only with the a- or b- prefix (--a-nodes 20000 --b-nodes 10000),
+// so a change of a parameter can be measured against the defaults (or a different time or node budget against the same engine)
+
+#include <iostream>
+#include <fstream>
+#include <sstream>
+#include <iomanip>
+#include <string>
+#include <vector>
+#include <thread>
+#include <mutex>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <bit>
+#include <algorithm>
+
+#include "../board.h"
+#include "../computer.h"
+
+using namespace std;
+
+const string start_fen = "rnbqkbnr/pppppppp/8/8/8/8/PPPPPPPP/RNBQKBNR w KQkq - 0 1";
+
+// a few moves of common openings so the games don't all start the same way
+vector<string> default_openings =
+{
+	"e2e4 e7e5 g1f3 b8c6 f1b5 a7a6",
+	"e2e4 e7e5 g1f3 b8c6 f1c4 f8c5",
+	"e2e4 e7e5 g1f3 g8f6",
+	"e2e4 c7c5 g1f3 d7d6 d2d4 c5d4 f3d4 g8f6 b1c3",
+	"e2e4 c7c5 b1c3 b8c6",
+	"e2e4 e7e6 d2d4 d7d5",
+	"e2e4 c7c6 d2d4 d7d5",
+	"e2e4 d7d5 e4d5 d8d5",
+	"e2e4 g7g6 d2d4 f8g7",
+	"d2d4 d7d5 c2c4 e7e6 b1c3 g8f6",
+	"d2d4 d7d5 c2c4 c7c6",
+	"d2d4 d7d5 c2c4 d5c4",
+	"d2d4 g8f6 c2c4 e7e6 b1c3 f8b4",
+	"d2d4 g8f6 c2c4 e7e6 g1f3 b7b6",
+	"d2d4 g8f6 c2c4 g7g6 b1c3 f8g7 e2e4 d7d6",
+	"d2d4 f7f5",
+	"c2c4 e7e5 b1c3 g8f6",
+	"g1f3 d7d5 g2g3 g8f6 f1g2",
+};
+
+struct engine_options_t
+{
+	search_limits_t limits;
+	size_t hash_mb = 16;
+	int threads = 1;
+	search_parameters_t parameters;
+};
+
+struct match_options_t
+{
+	// [0] is engine a, [1] is engine b
+	engine_options_t engines[2];
+
+	int games = 100;
+	int concurrency = max(1, (int)thread::hardware_concurrency());
+	string openings_file;
+
+	bool sprt = false;
+	double elo0 = 0;
+	double elo1 = 5;
+	double alpha = 0.05;
+	double beta = 0.05;
+
+	int resign_score = 1000;
+	int resign_moves = 3;
+	int draw_score = 10;
+	int draw_moves = 8;
+	int draw_after = 40;
+	int max_moves = 300;
+};
+
+struct opening_t
+{
+	ChessBoard start;
+	vector<move_t> moves;
+};
+
+enum class game_result_t
+{
+	a_wins,
+	draw,
+	b_wins,
+	// the match was stopped before the game ended, it isn't counted
+	aborted,
+};
+
+// games from the point of view of engine a
+struct match_score_t
+{
+	int wins = 0;
+	int draws = 0;
+	int losses = 0;
+
+	int games() const
+	{
+		return wins + draws + losses;
+	}
+
+	double score() const
+	{
+		return games() ? (wins + draws / 2.0) / games() : 0.5;
+	}
+
+	// variance of the result of one game
+	double variance() const
+	{
+		if (!games())
+			return 0;
+
+		double s = score();
+		return (wins * (1 - s) * (1 - s) + draws * (0.5 - s) * (0.5 - s) + losses * s * s) / games();
+	}
+
+	static double score_to_elo(double s)
+	{
+		s = clamp(s, 1e-6, 1 - 1e-6);
+		return -400 * log10(1 / s - 1);
+	}
+
+	static double elo_to_score(double elo)
+	{
+		return 1 / (1 + pow(10, -elo / 400));
+	}
+
+	double elo() const
+	{
+		return score_to_elo(score());
+	}
+
+	// half of the 95% confidence interval
+	double elo_error() const
+	{
+		if (!games())
+			return 0;
+
+		double error = 1.96 * sqrt(variance() / games());
+		return (score_to_elo(score() + error) - score_to_elo(score() - error)) / 2;
+	}
+
+	// log likelihood ratio of elo1 against elo0, with the results approximated by a normal distribution
+	double llr(double elo0, double elo1) const
+	{
+		double v = variance();
+		if (v == 0)
+			return 0;
+
+		double s0 = elo_to_score(elo0);
+		double s1 = elo_to_score(elo1);
+		return games() * (s1 - s0) * (2 * score() - s0 - s1) / (2 * v);
+	}
+};
+
+// a fen (or epd) line, otherwise uci moves played from the start position
+bool parse_opening(const string& line, opening_t& opening)
+{
+	istringstream stream(line);
+	vector<string> fields;
+	string field;
+	while (stream >> field)
+		fields.push_back(field);
+
+	if (fields.empty())
+		return false;
+
+	if (fields.size() >= 4 && (fields[1] == "w" || fields[1] == "b"))
+	{
+		if (fields[3] != "-" && (fields[3].size() != 2 || fields[3][0] < 'a' || fields[3][0] > 'h' || (fields[3][1] != '3' && fields[3][1] != '6')))
+			return false;
+
+		string fen = fields[0] + " " + fields[1] + " " + fields[2] + " " + fields[3];
+		if (fields.size() >= 6 && all_of(fields[4].begin(), fields[4].end(), ::isdigit))
+			fen += " " + fields[4];
+
+		// besides the kings and checks this rejects castling rights without their king and rook at home
+		// and en-passant squares without the pawn that skipped them, the games would crash on the first castling or en-passant capture
+		opening.start.from_fen(fen);
+		if (!opening.start.is_legal_position())
+			return false;
+
+		// a position that is already over can't be played
+		MoveList moves;
+		opening.start.generate_moves(moves);
+		return !moves.empty();
+	}
+
+	opening.start.from_fen(start_fen);
+	ChessBoard board = opening.start;
+	for (const string& uci_move : fields)
+	{
+		if ((uci_move.size() != 4 && uci_move.size() != 5) || uci_move[0] < 'a' || uci_move[0] > 'h' || uci_move[1] < '1' || uci_move[1] > '8'
+			|| uci_move[2] < 'a' || uci_move[2] > 'h' || uci_move[3] < '1' || uci_move[3] > '8')
+			return false;
+
+		move_t chess_move = board.uci_to_move_t(uci_move);
+		if (!board.is_move_legal(chess_move))
+			return false;
+
+		opening.moves.push_back(chess_move);
+		board.move(chess_move);
+	}
+
+	return true;
+}
+
+bool load_openings(const match_options_t& options, vector<opening_t>& openings)
+{
+	vector<string> lines = default_openings;
+	if (!options.openings_file.empty())
+	{
+		ifstream file(options.openings_file);
+		if (!file)
+			return false;
+
+		lines.clear();
+		string line;
+		while (getline(file, line))
+			lines.push_back(line);
+	}
+
+	for (size_t i = 0; i < lines.size(); i++)
+	{
+		if (all_of(lines[i].begin(), lines[i].end(), ::isspace) || lines[i][0] == '#')
+			continue;
+
+		opening_t opening;
+		if (parse_opening(lines[i], opening))
+			openings.push_back(opening);
+		else
+			cout << "skipped opening on line " << i + 1 << ": " << lines[i] << endl;
+	}
+
+	return !openings.empty();
+}
+
+// https://www.chessprogramming.org/Draw
+// only the positions where neither side can mate in any way, kings alone or with one minor piece
+bool is_insufficient_material(ChessBoard& board)
+{
+	return !board.pawns && !board.rooks && !board.queens && popcount(board.knights | board.bishops) <= 1;
+}
+
+class GamePlayer
+{
+	const match_options_t& options;
+	// [0] is engine a, [1] is engine b
+	Computer engines[2];
+
+	// the clock of an engine with a time control is kept here because the computer doesn't know about it
+	chrono::milliseconds clocks[2];
+
+public:
+	GamePlayer(const match_options_t& options)
+		: options(options)
+	{
+		for (int i = 0; i < 2; i++)
+		{
+			engines[i].set_info_output(info_output_t::none);
+			engines[i].set_hash_size(options.engines[i].hash_mb);
+			engines[i].set_threads(options.engines[i].threads);
+			engines[i].set_parameters(options.engines[i].parameters);
+		}
+	}
+
+	game_result_t play(const opening_t& opening, bool a_white, const atomic<bool>& stop, string& reason)
+	{
+		ChessBoard board = opening.start;
+		RepetitionHistory history;
+		for (move_t chess_move : opening.moves)
+		{
+			history.add_game_position(board.hash_key);
+			board.move(chess_move);
+		}
+
+		vector<move_t> moves = opening.moves;
+		for (int i = 0; i < 2; i++)
+		{
+			engines[i].new_game();
+			clocks[i] = options.engines[i].limits.time_left;
+		}
+
+		// a result for white is turned into one for engine a
+		auto result = [a_white](int white_score)
+			{
+				if (white_score == 0)
+					return game_result_t::draw;
+				return (white_score > 0) == a_white ? game_result_t::a_wins : game_result_t::b_wins;
+			};
+
+		// plies in a row where both engines saw the same side winning or the game as a draw
+		int resign_plies = 0;
+		int resign_side = 0;
+		int draw_plies = 0;
+
+		for (int ply = 0; ; ply++)
+		{
+			if (stop)
+				return game_result_t::aborted;
+
+			MoveList legal_moves;
+			board.generate_moves(legal_moves);
+			if (legal_moves.empty())
+			{
+				reason = board.in_check() ? "checkmate" : "stalemate";
+				return result(board.in_check() ? (board.white_to_move ? -1 : 1) : 0);
+			}
+
+			if (board.last_pawn_move >= 100)
+				reason = "fifty move rule";
+			else if (history.is_repetition(board.hash_key, board.last_pawn_move))
+				reason = "threefold repetition";
+			else if (is_insufficient_material(board))
+				reason = "insufficient material";
+			else if (ply >= options.max_moves * 2)
+				reason = "maximum game length";
+			if (!reason.empty())
+				return game_result_t::draw;
+
+			int side = board.white_to_move == a_white ? 0 : 1;
+			const engine_options_t& engine_options = options.engines[side];
+			Computer& engine = engines[side];
+
+			search_limits_t limits = engine_options.limits;
+			if (limits.time_left.count() > 0)
+				limits.time_left = clocks[side];
+
+			engine.set_game(opening.start, moves);
+			auto start = chrono::steady_clock::now();
+			pair<move_t, int> search_result = engine.deapening_search(limits);
+			chrono::milliseconds elapsed = chrono::duration_cast<chrono::milliseconds>(chrono::steady_clock::now() - start);
+
+			if (limits.time_left.count() > 0)
+			{
+				clocks[side] -= elapsed;
+				if (clocks[side].count() < 0)
+				{
+					reason = "time forfeit";
+					return result(board.white_to_move ? -1 : 1);
+				}
+				clocks[side] += limits.increment;
+			}
+
+			// https://www.chessprogramming.org/Adjudication
+			int white_eval = board.white_to_move ? search_result.second : -search_result.second;
+			int winning_side = white_eval >= options.resign_score ? 1 : white_eval <= -options.resign_score ? -1 : 0;
+			resign_plies = winning_side && winning_side == resign_side ? resign_plies + 1 : (winning_side ? 1 : 0);
+			resign_side = winning_side;
+			if (options.resign_score > 0 && resign_plies >= options.resign_moves * 2)
+			{
+				reason = "resign adjudication";
+				return result(resign_side);
+			}
+
+			draw_plies = abs(white_eval) <= options.draw_score ? draw_plies + 1 : 0;
+			if (options.draw_moves > 0 && (int)moves.size() >= options.draw_after * 2 && draw_plies >= options.draw_moves * 2)
+			{
+				reason = "draw adjudication";
+				return game_result_t::draw;
+			}
+
+			history.add_game_position(board.hash_key);
+			board.move(search_result.first);
+			moves.push_back(search_result.first);
+		}
+	}
+};
+
+// parses "S+I" in seconds, the increment is optional
+bool parse_time_control(const string& tc, search_limits_t& limits)
+{
+	size_t plus = tc.find('+');
+	try
+	{
+		limits.time_left = chrono::milliseconds((long long)(stod(tc.substr(0, plus)) * 1000));
+		limits.increment = chrono::milliseconds(plus == string::npos ? 0 : (long long)(stod(tc.substr(plus + 1)) * 1000));
+	}
+	catch (...)
+	{
+		return false;
+	}
+
+	limits.move_time = chrono::milliseconds(0);
+	limits.nodes = 0;
+	limits.depth = 0;
+	return limits.time_left.count() > 0;
+}
+
+// the search options apply to both engines unless they have the a- or b- prefix
+bool parse_engine_option(const string& arg, const string& value, match_options_t& options)
+{
+	int first = 0, last = 1;
+	string name = arg.substr(2);
+	if (name.rfind("a-", 0) == 0 || name.rfind("b-", 0) == 0)
+	{
+		first = last = name[0] == 'a' ? 0 : 1;
+		name = name.substr(2);
+	}
+
+	for (int i = first; i <= last; i++)
+	{
+		engine_options_t& engine = options.engines[i];
+
+		// a fixed limit per move replaces the clock
+		if (name == "movetime" || name == "nodes" || name == "depth")
+		{
+			engine.limits.time_left = chrono::milliseconds(0);
+			engine.limits.increment = chrono::milliseconds(0);
+		}
+
+		if (name == "tc")
+		{
+			if (!parse_time_control(value, engine.limits))
+				return false;
+		}
+		else if (name == "movetime")
+			engine.limits.move_time = chrono::milliseconds(stoll(value));
+		else if (name == "nodes")
+			engine.limits.nodes = stoull(value);
+		else if (name == "depth")
+			engine.limits.depth = stoi(value);
+		else if (name == "hash")
+			engine.hash_mb = max<size_t>(1, stoul(value));
+		else if (name == "threads")
+			engine.threads = max(1, stoi(value));
+		else if (name == "param")
+		{
+			size_t equals = value.find('=');
+			if (equals == string::npos || !engine.parameters.set(value.substr(0, equals), stoi(value.substr(equals + 1))))
+				return false;
+		}
+		else
+			return false;
+	}
+
+	return true;
+}
+
+void print_score(const match_score_t& score, const match_options_t& options)
+{
+	cout << "a +" << score.wins << " =" << score.draws << " -" << score.losses
+		<< " score " << fixed << setprecision(1) << 100 * score.score() << "%"
+		<< " elo " << score.elo() << " +- " << score.elo_error();
+
+	if (options.sprt)
+		cout << " llr " << setprecision(2) << score.llr(options.elo0, options.elo1)
+		<< " (" << log(options.beta / (1 - options.alpha)) << ", " << log((1 - options.beta) / options.alpha) << ")";
+
+	cout << endl;
+}
+
+int main(int argc, char* argv[])
+{
+	match_options_t options;
+	parse_time_control("1+0.01", options.engines[0].limits);
+	parse_time_control("1+0.01", options.engines[1].limits);
+
+	for (int i = 1; i < argc; i++)
+	{
+		string arg = argv[i];
+		bool has_value = i + 1 < argc;
+
+		if (arg == "--games" && has_value)
+			options.games = max(1, stoi(argv[++i]));
+		else if (arg == "--concurrency" && has_value)
+			options.concurrency = max(1, stoi(argv[++i]));
+		else if (arg == "--openings" && has_value)
+			options.openings_file = argv[++i];
+		else if (arg == "--sprt" && i + 2 < argc)
+		{
+			options.sprt = true;
+			options.elo0 = stod(argv[++i]);
+			options.elo1 = stod(argv[++i]);
+		}
+		else if (arg == "--alpha" && has_value)
+			options.alpha = stod(argv[++i]);
+		else if (arg == "--beta" && has_value)
+			options.beta = stod(argv[++i]);
+		else if (arg == "--resign-score" && has_value)
+			options.resign_score = stoi(argv[++i]);
+		else if (arg == "--resign-moves" && has_value)
+			options.resign_moves = stoi(argv[++i]);
+		else if (arg == "--draw-score" && has_value)
+			options.draw_score = stoi(argv[++i]);
+		else if (arg == "--draw-moves" && has_value)
+			options.draw_moves = stoi(argv[++i]);
+		else if (arg == "--draw-after" && has_value)
+			options.draw_after = stoi(argv[++i]);
+		else if (arg == "--max-moves" && has_value)
+			options.max_moves = stoi(argv[++i]);
+		else if (!has_value || !parse_engine_option(arg, argv[++i], options))
+		{
+			cout << "unknown option: " << arg << (has_value ? " " + string(argv[i]) : "") << endl;
+			if (arg.ends_with("param"))
+			{
+				cout << "parameters:";
+				for (const auto& parameter : search_parameters_t::names())
+					cout << " " << parameter.first;
+				cout << endl;
+			}
+			return 1;
+		}
+	}
+
+	vector<opening_t> openings;
+	if (!load_openings(options, openings))
+	{
+		cout << "no openings in " << options.openings_file << endl;
+		return 1;
+	}
+
+	// https://www.chessprogramming.org/Sequential_Probability_Ratio_Test
+	// the test stops once the log likelihood ratio leaves the bounds given by the error probabilities
+	double lower_bound = log(options.beta / (1 - options.alpha));
+	double upper_bound = log((1 - options.beta) / options.alpha);
+
+	atomic<int> next_game = 0;
+	atomic<bool> stop = false;
+
+	mutex score_mutex;
+	match_score_t score;
+
+	auto worker = [&]()
+		{
+			GamePlayer player(options);
+
+			for (int game = next_game++; game < options.games && !stop; game = next_game++)
+			{
+				// every opening is played once with each color
+				const opening_t& opening = openings[(game / 2) % openings.size()];
+				bool a_white = game % 2 == 0;
+
+				string reason;
+				game_result_t result = player.play(opening, a_white, stop, reason);
+				if (result == game_result_t::aborted)
+					return;
+
+				lock_guard<mutex> lock(score_mutex);
+				score.wins += result == game_result_t::a_wins;
+				score.draws += result == game_result_t::draw;
+				score.losses += result == game_result_t::b_wins;
+
+				cout << "game " << game + 1 << " a " << (a_white ? "white" : "black") << " "
+					<< (result == game_result_t::draw ? "1/2-1/2" : (result == game_result_t::a_wins) == a_white ? "1-0" : "0-1")
+					<< " " << reason << " | ";
+				print_score(score, options);
+
+				if (options.sprt)
+				{
+					double llr = score.llr(options.elo0, options.elo1);
+					if (llr <= lower_bound || llr >= upper_bound)
+						stop = true;
+				}
+			}
+		};
+
+	auto start = chrono::steady_clock::now();
+
+	vector<thread> threads;
+	for (int i = 0; i < options.concurrency; i++)
+		threads.emplace_back(worker);
+
+	for (thread& t : threads)
+		t.join();
+
+	double seconds = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+
+	cout << endl << "games " << score.games() << " time " << fixed << setprecision(1) << seconds << "s" << endl;
+	print_score(score, options);
+
+	if (options.sprt)
+	{
+		double llr = score.llr(options.elo0, options.elo1);
+		cout << "sprt elo0 " << options.elo0 << " elo1 " << options.elo1 << ": "
+			<< (llr >= upper_bound ? "H1 accepted" : llr <= lower_bound ? "H0 accepted" : "inconclusive") << endl;
+	}
+
+	return 0;
+}
@@ -0,0 +1,290 @@
+// perft.cpp
+//
+// headless move generator benchmark
+// https://www.chessprogramming.org/Perft
+//
+// usage:
+//   perft                              runs the standard position suite
+//   perft --fen "<fen>" --depth 5      runs a single position
+// options:
+//   --depth N       overrides the depth of every position
+//   --threads N     splits the root moves between N threads
+//   --hash MB       enables the hashed perft cache (per thread)
+//   --divide        prints the node count for every root move
+//   --no-bulk       disables bulk counting at the last ply
+
+#include <iostream>
+#include <iomanip>
+#include <string>
+#include <vector>
+#include <thread>
+#include <atomic>
+#include <chrono>
+#include <algorithm>
+
+#include "../board.h"
+
+using namespace std;
+
+struct perft_position_t
+{
+	string name;
+	string fen;
+	int depth;
+	uint64_t expected;
+};
+
+// https://www.chessprogramming.org/Perft_Results
+// the edge cases come from the well known perft suite of Peter Ellis Jones
+vector<perft_position_t> perft_suite =
+{
+	{ "startpos",               "rnbqkbnr/pppppppp/8/8/8/8/PPPPPPPP/RNBQKBNR w KQkq - 0 1", 5, 4865609 },
+	{ "kiwipete",               "r3k2r/p1ppqpb1/bn2pnp1/3PN3/1p2P3/2N2Q1p/PPPBBPPP/R3K2R w KQkq - 0 1", 4, 4085603 },
+	{ "position 3",             "8/2p5/3p4/KP5r/1R3p1k/8/4P1P1/8 w - - 0 1", 5, 674624 },
+	{ "position 4",             "r3k2r/Pppp1ppp/1b3nbN/nP6/BBP1P3/q4N2/Pp1P2PP/R2Q1RK1 w kq - 0 1", 4, 422333 },
+	{ "position 5",             "rnbq1k1r/pp1Pbppp/2p5/8/2B5/8/PPP1NnPP/RNBQK2R w KQ - 1 8", 4, 2103487 },
+	{ "position 6",             "r4rk1/1pp1qppp/p1np1n2/2b1p1B1/2B1P1b1/P1NP1N2/1PP1QPPP/R4RK1 w - - 0 10", 4, 3894594 },
+	{ "illegal ep move #1",     "3k4/3p4/8/K1P4r/8/8/8/8 b - - 0 1", 6, 1134888 },
+	{ "illegal ep move #2",     "8/8/4k3/8/2p5/8/B2P2K1/8 w - - 0 1", 6, 1015133 },
+	{ "ep capture checks",      "8/8/1k6/2b5/2pP4/8/5K2/8 b - d3 0 1", 6, 1440467 },
+	{ "short castling check",   "5k2/8/8/8/8/8/8/4K2R w K - 0 1", 6, 661072 },
+	{ "long castling check",    "3k4/8/8/8/8/8/8/R3K3 w Q - 0 1", 6, 803711 },
+	{ "castle rights",          "r3k2r/1b4bq/8/8/8/8/7B/R3K2R w KQkq - 0 1", 4, 1274206 },
+	{ "castling prevented",     "r3k2r/8/3Q4/8/8/5q2/8/R3K2R b KQkq - 0 1", 4, 1720476 },
+	{ "promote out of check",   "2K2r2/4P3/8/8/8/8/8/3k4 w - - 0 1", 6, 3821001 },
+	{ "discovered check",       "8/8/1P2K3/8/2n5/1q6/8/5k2 b - - 0 1", 5, 1004658 },
+	{ "promote to give check",  "4k3/1P6/8/8/8/8/K7/8 w - - 0 1", 6, 217342 },
+	{ "under promote check",    "8/P1k5/K7/8/8/8/8/8 w - - 0 1", 6, 92683 },
+	{ "self stalemate",         "K1k5/8/P7/8/8/8/8/8 w - - 0 1", 6, 2217 },
+	{ "stalemate and mate",     "8/k1P5/8/1K6/8/8/8/8 w - - 0 1", 7, 567584 },
+	{ "double check",           "8/8/2k5/5q2/5n2/8/5K2/8 b - - 0 1", 4, 23527 },
+};
+
+struct perft_options_t
+{
+	int depth = 0;
+	int threads = 1;
+	size_t hash_mb = 0;
+	bool divide = false;
+	bool bulk = true;
+};
+
+// small always-replace cache of subtree sizes
+// every thread owns one so no synchronisation is needed
+class PerftCache
+{
+	struct entry_t
+	{
+		uint64_t key = 0;
+		int depth = -1;
+		uint64_t nodes = 0;
+	};
+
+	vector<entry_t> entries;
+
+public:
+	uint64_t hits = 0;
+
+	PerftCache(size_t size_mb)
+	{
+		size_t count = size_mb * 1024 * 1024 / sizeof(entry_t);
+		entries.resize(count);
+	}
+
+	bool enabled()
+	{
+		return !entries.empty();
+	}
+
+	bool probe(uint64_t key, int depth, uint64_t& nodes)
+	{
+		entry_t& entry = entries[key % entries.size()];
+		if (entry.depth != depth || entry.key != key)
+			return false;
+
+		hits++;
+		nodes = entry.nodes;
+		return true;
+	}
+
+	void store(uint64_t key, int depth, uint64_t nodes)
+	{
+		entry_t& entry = entries[key % entries.size()];
+		entry.key = key;
+		entry.depth = depth;
+		entry.nodes = nodes;
+	}
+};
+
+uint64_t perft(ChessBoard& board, int depth, PerftCache& cache, bool bulk)
+{
+	if (depth == 0)
+		return 1;
+
+	if (cache.enabled())
+	{
+		uint64_t nodes;
+		if (cache.probe(board.hash_key, depth, nodes))
+			return nodes;
+	}
+
+	MoveList moves;
+	board.generate_moves(moves);
+
+	// every generated move is legal so the last ply doesn't have to be played
+	if (bulk && depth == 1)
+		return moves.size();
+
+	uint64_t nodes = 0;
+	for (move_t chess_move : moves)
+	{
+		board.move(chess_move);
+		nodes += perft(board, depth - 1, cache, bulk);
+		board.undo_move();
+	}
+
+	if (cache.enabled())
+		cache.store(board.hash_key, depth, nodes);
+
+	return nodes;
+}
+
+// root moves are handed out one by one so the threads stay busy even when the subtrees differ in size
+uint64_t perft_root(const string& fen, int depth, const perft_options_t& options, uint64_t& cache_hits)
+{
+	ChessBoard root;
+	root.from_fen(fen);
+
+	MoveList root_moves;
+	root.generate_moves(root_moves);
+	vector<uint64_t> move_nodes(root_moves.size(), 0);
+
+	atomic<size_t> next_move = 0;
+	atomic<uint64_t> hits = 0;
+
+	auto worker = [&]()
+		{
+			ChessBoard board;
+			board.from_fen(fen);
+			PerftCache cache(options.hash_mb);
+
+			for (size_t i = next_move++; i < root_moves.size(); i = next_move++)
+			{
+				board.move(root_moves[i]);
+				move_nodes[i] = perft(board, depth - 1, cache, options.bulk);
+				board.undo_move();
+			}
+
+			hits += cache.hits;
+		};
+
+	vector<thread> threads;
+	for (int i = 1; i < options.threads; i++)
+		threads.emplace_back(worker);
+
+	worker();
+
+	for (thread& t : threads)
+		t.join();
+
+	uint64_t nodes = 0;
+	for (uint64_t n : move_nodes)
+		nodes += n;
+
+	if (options.divide)
+	{
+		vector<pair<string, uint64_t>> lines;
+		for (size_t i = 0; i < root_moves.size(); i++)
+			lines.emplace_back(root.move_t_to_uci(root_moves[i]), move_nodes[i]);
+
+		sort(lines.begin(), lines.end());
+		for (auto& line : lines)
+			cout << line.first << ": " << line.second << '\n';
+		cout << '\n';
+	}
+
+	cache_hits = hits;
+	return depth == 0 ? 1 : nodes;
+}
+
+// returns true if the node count matches the expected one (or if there is nothing to compare with)
+bool run_position(const perft_position_t& position, const perft_options_t& options, uint64_t& total_nodes, double& total_seconds)
+{
+	int depth = options.depth ? options.depth : position.depth;
+	uint64_t cache_hits = 0;
+
+	auto start = chrono::steady_clock::now();
+	uint64_t nodes = perft_root(position.fen, depth, options, cache_hits);
+	auto end = chrono::steady_clock::now();
+
+	double seconds = chrono::duration<double>(end - start).count();
+	double nps = seconds > 0 ? nodes / seconds : 0;
+
+	total_nodes += nodes;
+	total_seconds += seconds;
+
+	bool compare = position.expected && (!options.depth || options.depth == position.depth);
+	bool correct = !compare || nodes == position.expected;
+
+	cout << left << setw(24) << position.name
+		<< " depth " << setw(2) << depth
+		<< " nodes " << setw(12) << nodes
+		<< " time " << fixed << setprecision(3) << setw(8) << seconds << "s"
+		<< " nps " << setw(12) << (uint64_t)nps;
+
+	if (options.hash_mb)
+		cout << " cache hits " << cache_hits;
+
+	if (compare)
+		cout << (correct ? " OK" : " FAILED (expected " + to_string(position.expected) + ")");
+
+	cout << endl;
+
+	return correct;
+}
+
+int main(int argc, char* argv[])
+{
+	perft_options_t options;
+	string fen;
+
+	for (int i = 1; i < argc; i++)
+	{
+		string arg = argv[i];
+
+		if (arg == "--depth" && i + 1 < argc)
+			options.depth = stoi(argv[++i]);
+		else if (arg == "--threads" && i + 1 < argc)
+			options.threads = max(1, stoi(argv[++i]));
+		else if (arg == "--hash" && i + 1 < argc)
+			options.hash_mb = stoul(argv[++i]);
+		else if (arg == "--fen" && i + 1 < argc)
+			fen = argv[++i];
+		else if (arg == "--divide")
+			options.divide = true;
+		else if (arg == "--no-bulk")
+			options.bulk = false;
+		else
+		{
+			cout << "unknown option: " << arg << endl;
+			return 1;
+		}
+	}
+
+	vector<perft_position_t> positions = perft_suite;
+	if (!fen.empty())
+		positions = { { "custom", fen, options.depth ? options.depth : 5, 0 } };
+
+	bool all_correct = true;
+	uint64_t total_nodes = 0;
+	double total_seconds = 0;
+
+	for (const perft_position_t& position : positions)
+		all_correct &= run_position(position, options, total_nodes, total_seconds);
+
+	cout << "total nodes " << total_nodes << " time " << fixed << setprecision(3) << total_seconds << "s"
+		<< " nps " << (uint64_t)(total_seconds > 0 ? total_nodes / total_seconds : 0) << endl;
+	cout << (all_correct ? "all positions correct" : "some positions FAILED") << endl;
+
+	return all_correct ? 0 : 1;
+}
@@ -0,0 +1,267 @@
+// uci.cpp
+//
+// headless engine speaking the universal chess interface, for match managers and analysis scripts
+// https://www.chessprogramming.org/UCI
+//
+// supported commands:
+//   uci, isready, ucinewgame, quit
+//   setoption name Hash value MB
+//   setoption name Threads value N
+//   setoption name MultiPV value N
+//   position startpos|fen <fen> [moves <move> ...]
+//   go [wtime T] [btime T] [winc T] [binc T] [movestogo N] [movetime T] [depth N] [nodes N] [infinite] [ponder]
+//   ponderhit, stop
+
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <vector>
+#include <thread>
+#include <atomic>
+#include <chrono>
+
+#include "../board.h"
+#include "../computer.h"
+
+using namespace std;
+
+const string start_fen = "rnbqkbnr/pppppppp/8/8/8/8/PPPPPPPP/RNBQKBNR w KQkq - 0 1";
+
+const int default_hash_mb = 64;
+const int max_hash_mb = 4096;
+const int max_threads = 256;
+const int max_multi_pv = 256;
+
+class UciEngine
+{
+	Computer computer;
+
+	// the position after the moves of the last position command
+	ChessBoard board;
+
+	thread search_thread;
+	// an infinite or pondering search waits for stop (or ponderhit) before sending its best move
+	atomic<bool> stop_requested = false;
+	atomic<bool> pondering = false;
+
+	void set_position(istringstream& command)
+	{
+		string token;
+		command >> token;
+
+		ChessBoard start;
+		if (token == "startpos")
+		{
+			start.from_fen(start_fen);
+			command >> token;
+		}
+		else if (token == "fen")
+		{
+			string fen;
+			while (command >> token && token != "moves")
+				fen += token + " ";
+			start.from_fen(fen);
+		}
+		else
+			return;
+
+		board = start;
+		vector<move_t> moves;
+		if (token == "moves")
+		{
+			// the moves are looked up among the legal ones, everything from the first move that isn't legal is ignored
+			while (command >> token)
+			{
+				MoveList legal_moves;
+				board.generate_moves(legal_moves);
+
+				move_t chess_move = null_move;
+				for (move_t legal_move : legal_moves)
+				{
+					if (board.move_t_to_uci(legal_move) == token)
+						chess_move = legal_move;
+				}
+
+				if (chess_move == null_move)
+					break;
+
+				moves.push_back(chess_move);
+				board.move(chess_move);
+			}
+		}
+
+		computer.set_game(start, moves);
+	}
+
+	void go(istringstream& command)
+	{
+		search_limits_t limits;
+
+		string token;
+		while (command >> token)
+		{
+			long long value = 0;
+			if (token == "infinite" || token == "ponder")
+			{
+				limits.infinite |= token == "infinite";
+				limits.ponder |= token == "ponder";
+				continue;
+			}
+
+			command >> value;
+			if (token == (board.white_to_move ? "wtime" : "btime"))
+				limits.time_left = chrono::milliseconds(value);
+			else if (token == (board.white_to_move ? "winc" : "binc"))
+				limits.increment = chrono::milliseconds(value);
+			else if (token == "movestogo")
+				limits.moves_to_go = (int)value;
+			else if (token == "movetime")
+				limits.move_time = chrono::milliseconds(value);
+			else if (token == "depth")
+				limits.depth = (int)value;
+			else if (token == "nodes")
+				limits.nodes = (uint64_t)value;
+		}
+
+		MoveList moves;
+		board.generate_moves(moves);
+
+		stop_requested = false;
+		pondering = limits.ponder;
+
+		// the search is set up here so a stop sent right after go can't come before it
+		computer.start_search(limits);
+		search_thread = thread([this, limits, no_moves = moves.empty()]()
+			{
+				string best_move = "0000";
+				string ponder_move;
+				if (!no_moves)
+				{
+					move_t chess_move = computer.run_search().first;
+					best_move = board.move_t_to_uci(chess_move);
+
+					move_t reply = computer.get_ponder_move(chess_move);
+					if (reply != null_move)
+					{
+						ChessBoard next = board;
+						next.move(chess_move);
+						ponder_move = " ponder " + next.move_t_to_uci(reply);
+					}
+				}
+
+				// the gui expects the best move of an infinite or pondering search only after it sends stop (or ponderhit)
+				while ((limits.infinite || pondering) && !stop_requested)
+					this_thread::sleep_for(chrono::milliseconds(1));
+
+				cout << "bestmove " << best_move << ponder_move << endl;
+			});
+	}
+
+	void stop()
+	{
+		if (!search_thread.joinable())
+			return;
+
+		stop_requested = true;
+		computer.stop();
+		search_thread.join();
+	}
+
+	void ponder_hit()
+	{
+		pondering = false;
+		computer.ponder_hit();
+	}
+
+	void set_option(istringstream& command)
+	{
+		string token, name, value;
+		command >> token;
+		while (command >> token && token != "value")
+			name += (name.empty() ? "" : " ") + token;
+		command >> value;
+
+		if (name == "Hash")
+			computer.set_hash_size(clamp(stoi(value), 1, max_hash_mb));
+		else if (name == "Threads")
+			computer.set_threads(clamp(stoi(value), 1, max_threads));
+		else if (name == "MultiPV")
+			computer.set_multi_pv(clamp(stoi(value), 1, max_multi_pv));
+	}
+
+public:
+	UciEngine()
+	{
+		computer.set_info_output(info_output_t::uci);
+		board.from_fen(start_fen);
+		computer.set_board(board);
+	}
+
+	~UciEngine()
+	{
+		stop();
+	}
+
+	// returns false after quit
+	bool handle(const string& line)
+	{
+		istringstream command(line);
+		string token;
+		command >> token;
+
+		if (token == "uci")
+		{
+			cout << "id name Chess engine" << endl;
+			cout << "id author Pawel Deorowicz" << endl;
+			cout << "option name Hash type spin default " << default_hash_mb << " min 1 max " << max_hash_mb << endl;
+			cout << "option name Threads type spin default 1 min 1 max " << max_threads << endl;
+			cout << "option name MultiPV type spin default 1 min 1 max " << max_multi_pv << endl;
+			cout << "option name Ponder type check default false" << endl;
+			cout << "uciok" << endl;
+		}
+		else if (token == "isready")
+			cout << "readyok" << endl;
+		else if (token == "ucinewgame")
+		{
+			stop();
+			computer.new_game();
+		}
+		else if (token == "setoption")
+		{
+			stop();
+			set_option(command);
+		}
+		else if (token == "position")
+		{
+			stop();
+			set_position(command);
+		}
+		else if (token == "go")
+		{
+			stop();
+			go(command);
+		}
+		else if (token == "stop")
+			stop();
+		else if (token == "ponderhit")
+			ponder_hit();
+		else if (token == "quit")
+			return false;
+
+		return true;
+	}
+};
+
+int main()
+{
+	UciEngine engine;
+
+	string line;
+	while (getline(cin, line))
+	{
+		if (!engine.handle(line))
+			break;
+	}
+
+	return 0;
+}
@@ -0,0 +1,274 @@
+#pragma once
+
+#include <cstdint>
+#include <climits>
+#include <vector>
+#include <atomic>
+#include <algorithm>
+#include <bit>
+#include <xmmintrin.h>
+
+using namespace std;
+
+enum class node_type_t
+{
+	exact = 0,
+	lower_bound = 1,
+	upper_bound = 2,
+};
+
+// what the table remembers about a position
+struct transposition_table_entry
+{
+	// the no_static_eval value is used for a position that was never evaluated (e.g. because it was in check)
+	static constexpr int no_static_eval = INT16_MIN;
+
+	// both evals are saved in 16 bits
+	int eval;
+	int static_eval;
+	// bits 0-15 of move_t, the moving piece is read back from the board
+	uint16_t move;
+	int depth;
+	node_type_t node_type;
+};
+
+// 16 bytes, 4 of them fill a cache line
+// data bits 0-15 eval, bits 16-31 static eval, bits 32-47 move, bits 48-55 depth, bits 56-57 node type, bits 58-63 generation (0 means the slot was never written)
+// https://www.chessprogramming.org/Shared_Hash_Table#Lockless
+// the key is saved xored with the data, when two threads write the same slot at the same time
+// the halves don't match anymore and the slot is treated like a different position
+struct transposition_table_slot
+{
+	atomic<uint64_t> checked_key;
+	atomic<uint64_t> data;
+};
+
+struct alignas(64) transposition_table_bucket
+{
+	static constexpr int size = 4;
+	transposition_table_slot slots[size];
+};
+
+static_assert(sizeof(transposition_table_bucket) == 64, "a bucket should take exactly one cache line");
+
+/*
+https://www.chessprogramming.org/Transposition_Table
+fixed size table allocated once, the zobrist key picks a bucket (one cache line) and the position is searched for only inside of it.
+every search increases the generation, when a bucket is full the entry with the smallest depth and the oldest generation gets replaced.
+the generations wrap around, the age of an entry is the distance to the current generation modulo the amount of generations.
+clearing the table only increases the generation and forgets everything written before it. after the generations went around once
+entries from before the clear can't be told apart from new ones anymore and become usable again, they are still the right results for their positions
+the table is shared by all search threads, every access is a relaxed atomic so no locks are needed
+*/
+class TranspositionTable
+{
+	// the generation has 6 bits in the entry, 0 is left for slots that were never written so there are 63 of them
+	static constexpr uint8_t generation_count = 63;
+
+	static constexpr uint32_t static_eval_shift = 16;
+	static constexpr uint32_t move_shift = 32;
+	static constexpr uint32_t depth_shift = 48;
+	static constexpr uint32_t node_type_shift = 56;
+	static constexpr uint32_t generation_shift = 58;
+
+	vector<transposition_table_bucket> buckets;
+	uint64_t index_mask = 0;
+
+	uint8_t generation = 1;
+	// entries older than this were written before the last clear
+	uint8_t generations_since_clear = 0;
+
+	transposition_table_bucket& get_bucket(uint64_t key)
+	{
+		return buckets[key & index_mask];
+	}
+
+	static uint64_t encode_data(int eval, int static_eval, uint16_t move, int depth, node_type_t node_type, uint8_t generation)
+	{
+		return (uint64_t)(uint16_t)eval |
+			((uint64_t)(uint16_t)static_eval << static_eval_shift) |
+			((uint64_t)move << move_shift) |
+			((uint64_t)(uint8_t)depth << depth_shift) |
+			((uint64_t)node_type << node_type_shift) |
+			((uint64_t)generation << generation_shift);
+	}
+
+	static uint16_t get_move(uint64_t data)
+	{
+		return (uint16_t)(data >> move_shift);
+	}
+
+	static int get_depth(uint64_t data)
+	{
+		return (int8_t)(data >> depth_shift);
+	}
+
+	static uint8_t get_generation(uint64_t data)
+	{
+		return (uint8_t)(data >> generation_shift);
+	}
+
+	// searches since the entry was written (or last used)
+	int get_age(uint64_t data) const
+	{
+		return (generation - get_generation(data) + generation_count) % generation_count;
+	}
+
+	bool is_valid(uint64_t data) const
+	{
+		return get_generation(data) != 0 && get_age(data) <= generations_since_clear;
+	}
+
+	// lower is replaced first
+	int replacement_score(uint64_t data) const
+	{
+		if (!is_valid(data))
+			return INT_MIN;
+
+		return get_depth(data) - 8 * get_age(data);
+	}
+
+	void wipe()
+	{
+		for (transposition_table_bucket& bucket : buckets)
+		{
+			for (transposition_table_slot& slot : bucket.slots)
+			{
+				slot.checked_key.store(0, memory_order_relaxed);
+				slot.data.store(0, memory_order_relaxed);
+			}
+		}
+	}
+
+	// goes from 63 back to 1
+	void next_generation()
+	{
+		generation = generation % generation_count + 1;
+		generations_since_clear = min<uint8_t>(generations_since_clear + 1, generation_count - 1);
+	}
+
+public:
+	TranspositionTable(size_t size_mb)
+	{
+		resize(size_mb);
+	}
+
+	// the amount of buckets is rounded down to a power of 2 so the index is just a mask
+	// must not be called while a search is running
+	void resize(size_t size_mb)
+	{
+		size_t count = bit_floor(max<size_t>(1, size_mb * 1024 * 1024 / sizeof(transposition_table_bucket)));
+
+		buckets = vector<transposition_table_bucket>(count);
+		index_mask = count - 1;
+		wipe();
+		generation = 1;
+		generations_since_clear = 0;
+	}
+
+	size_t size_mb() const
+	{
+		return buckets.size() * sizeof(transposition_table_bucket) / (1024 * 1024);
+	}
+
+	void clear()
+	{
+		next_generation();
+		generations_since_clear = 0;
+	}
+
+	// called at the start of every search so the entries of old searches are replaced first
+	void new_search()
+	{
+		next_generation();
+	}
+
+	// starts loading the bucket into the cache, search calls it right after making a move
+	// so the memory access overlaps with the move generation and evaluation of the new position
+	void prefetch(uint64_t key)
+	{
+		_mm_prefetch((const char*)&get_bucket(key), _MM_HINT_T0);
+	}
+
+	// returns false if the position isn't in the table
+	bool probe(uint64_t key, transposition_table_entry& entry)
+	{
+		for (transposition_table_slot& slot : get_bucket(key).slots)
+		{
+			uint64_t data = slot.data.load(memory_order_relaxed);
+			if ((slot.checked_key.load(memory_order_relaxed) ^ data) != key || !is_valid(data))
+				continue;
+
+			entry.eval = (int16_t)data;
+			entry.static_eval = (int16_t)(data >> static_eval_shift);
+			entry.move = get_move(data);
+			entry.depth = get_depth(data);
+			entry.node_type = (node_type_t)((data >> node_type_shift) & 3);
+
+			// the entry is still useful, so it shouldn't be replaced as an old one
+			if (get_generation(data) != generation)
+			{
+				data = encode_data(entry.eval, entry.static_eval, entry.move, entry.depth, entry.node_type, generation);
+				slot.checked_key.store(key ^ data, memory_order_relaxed);
+				slot.data.store(data, memory_order_relaxed);
+			}
+
+			return true;
+		}
+
+		return false;
+	}
+
+	// permille of the slots written (or used) during the current search, estimated from the first 1000 slots
+	int hashfull() const
+	{
+		int used = 0;
+		int slots = 0;
+		for (size_t i = 0; i < buckets.size() && slots < 1000; i++)
+		{
+			for (const transposition_table_slot& slot : buckets[i].slots)
+			{
+				slots++;
+				if (get_generation(slot.data.load(memory_order_relaxed)) == generation)
+					used++;
+			}
+		}
+
+		return used * 1000 / slots;
+	}
+
+	// eval and static_eval have to fit in 16 bits
+	void store(uint64_t key, int depth, int eval, int static_eval, node_type_t node_type, uint16_t move)
+	{
+		transposition_table_bucket& bucket = get_bucket(key);
+
+		transposition_table_slot* replace = &bucket.slots[0];
+		uint64_t replace_data = replace->data.load(memory_order_relaxed);
+		bool same_position = false;
+		for (transposition_table_slot& slot : bucket.slots)
+		{
+			uint64_t data = slot.data.load(memory_order_relaxed);
+			if ((slot.checked_key.load(memory_order_relaxed) ^ data) == key && is_valid(data))
+			{
+				replace = &slot;
+				replace_data = data;
+				same_position = true;
+				break;
+			}
+
+			if (replacement_score(data) < replacement_score(replace_data))
+			{
+				replace = &slot;
+				replace_data = data;
+			}
+		}
+
+		// a store without a move keeps the move found by an earlier search of the position
+		if (move == 0 && same_position)
+			move = get_move(replace_data);
+
+		uint64_t data = encode_data(eval, static_eval, move, depth, node_type, generation);
+		replace->checked_key.store(key ^ data, memory_order_relaxed);
+		replace->data.store(data, memory_order_relaxed);
+	}
+};
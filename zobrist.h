@@ -0,0 +1,57 @@
+#pragma once
+
+#include <cstdint>
+#include <array>
+
+/*
+https://www.chessprogramming.org/Zobrist_Hashing
+every (piece, square) pair, castling rights combination, en-passant file and the side to move gets a random number.
+the key of a position is the xor of the numbers of everything in it, so a move only has to xor out what changed and xor in the new state.
+the numbers are generated at compile time so they are the same in every build
+*/
+
+// https://www.chessprogramming.org/Xorshift
+constexpr uint64_t zobrist_next(uint64_t& state)
+{
+    state ^= state >> 12;
+    state ^= state << 25;
+    state ^= state >> 27;
+    return state * 2685821657736338717ull;
+}
+
+struct zobrist_keys_t
+{
+    // indexed by piece_t, the unused indexes stay 0
+    uint64_t pieces[16][64] = {};
+    uint64_t castlings[16] = {};
+    uint64_t en_passant[8] = {};
+    uint64_t black_to_move = 0;
+};
+
+constexpr zobrist_keys_t generate_zobrist_keys()
+{
+    zobrist_keys_t keys;
+    uint64_t state = 1070372ull;
+
+    for (int piece = 0; piece < 16; piece++)
+    {
+        // empty (0) and the unused values 7, 8 and 15
+        if (piece % 8 == 0 || piece % 8 == 7)
+            continue;
+
+        for (int square = 0; square < 64; square++)
+            keys.pieces[piece][square] = zobrist_next(state);
+    }
+
+    for (int i = 1; i < 16; i++)
+        keys.castlings[i] = zobrist_next(state);
+
+    for (int i = 0; i < 8; i++)
+        keys.en_passant[i] = zobrist_next(state);
+
+    keys.black_to_move = zobrist_next(state);
+
+    return keys;
+}
+
+inline constexpr zobrist_keys_t zobrist_keys = generate_zobrist_keys();